@@ -0,0 +1,240 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_integer.hpp"
+#include "big_integer_batch.hpp"
+
+/* Google Benchmark suite for the arithmetic hot paths from 1 to 10^6
+   decimal digits. The "mixed" argument gives the operands opposite signs,
+   so + and - take the subtracting branch. The batch rows compare BigIntBatch
+   with a loop over the same 10^4 pairs of small numbers. Usage:
+   big_integer_benchmark --benchmark_out=current.json
+   --benchmark_out_format=json, then compare_benchmarks.py baseline.json
+   current.json reports the changes and fails on regressions. */
+
+static constexpr int64_t kMinDigits = 1;
+static constexpr int64_t kMaxDigits = 1000000;
+// numbers per batch and the largest of them in limbs
+static constexpr size_t kBatchSize = 10000;
+static constexpr int64_t kMaxBatchLimbs = 32;
+
+static std::string RandomDigits(size_t digits, std::mt19937_64& gen) {
+  std::string number(digits, '0');
+  for (char& digit : number) {
+    digit = char('0' + gen() % 10);
+  }
+  number[0] = char('1' + gen() % 9);
+  return number;
+}
+// operands of the given lengths, the second one negative when mixed
+static std::pair<BigInt, BigInt> Operands(size_t lhs_digits, size_t rhs_digits,
+                                          bool mixed) {
+  std::mt19937_64 gen(lhs_digits * 31 + rhs_digits);
+  BigInt lhs(RandomDigits(lhs_digits, gen));
+  BigInt rhs(RandomDigits(rhs_digits, gen));
+  return {lhs, mixed ? -rhs : rhs};
+}
+static void SetDigits(benchmark::State& state, int64_t digits) {
+  state.counters["digits/s"] = benchmark::Counter(
+      double(digits), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void BM_FromString(benchmark::State& state) {
+  std::mt19937_64 gen(state.range(0));
+  std::string digits = RandomDigits(state.range(0), gen);
+  for (auto _ : state) {
+    BigInt num(digits);
+    benchmark::DoNotOptimize(num);
+  }
+  SetDigits(state, state.range(0));
+}
+static void BM_ToString(benchmark::State& state) {
+  BigInt num = Operands(state.range(0), 1, false).first;
+  for (auto _ : state) {
+    std::string digits = num.ToString();
+    benchmark::DoNotOptimize(digits);
+  }
+  SetDigits(state, state.range(0));
+}
+static void BM_Add(benchmark::State& state) {
+  auto [lhs, rhs] = Operands(state.range(0), state.range(0), state.range(1));
+  for (auto _ : state) {
+    BigInt sum = lhs + rhs;
+    benchmark::DoNotOptimize(sum);
+  }
+  SetDigits(state, state.range(0));
+}
+static void BM_Sub(benchmark::State& state) {
+  auto [lhs, rhs] = Operands(state.range(0), state.range(0), state.range(1));
+  for (auto _ : state) {
+    BigInt diff = lhs - rhs;
+    benchmark::DoNotOptimize(diff);
+  }
+  SetDigits(state, state.range(0));
+}
+// in place on a number that keeps its length, so the capacity is reused
+static void BM_AddAssign(benchmark::State& state) {
+  auto [lhs, rhs] = Operands(state.range(0), state.range(0), state.range(1));
+  for (auto _ : state) {
+    lhs += rhs;
+    lhs -= rhs;
+    benchmark::DoNotOptimize(lhs);
+  }
+  SetDigits(state, state.range(0));
+}
+static void BM_Mul(benchmark::State& state) {
+  auto [lhs, rhs] = Operands(state.range(0), state.range(0), state.range(1));
+  for (auto _ : state) {
+    BigInt product = lhs * rhs;
+    benchmark::DoNotOptimize(product);
+  }
+  SetDigits(state, state.range(0));
+}
+// a dividend twice as long as the divisor, the usual shape in reductions
+static void BM_Div(benchmark::State& state) {
+  auto [lhs, rhs] =
+      Operands(2 * state.range(0), state.range(0), state.range(1));
+  for (auto _ : state) {
+    BigInt quot = lhs / rhs;
+    benchmark::DoNotOptimize(quot);
+  }
+  SetDigits(state, state.range(0));
+}
+static void BM_Mod(benchmark::State& state) {
+  auto [lhs, rhs] =
+      Operands(2 * state.range(0), state.range(0), state.range(1));
+  for (auto _ : state) {
+    BigInt rem = lhs % rhs;
+    benchmark::DoNotOptimize(rem);
+  }
+  SetDigits(state, state.range(0));
+}
+// equal numbers apart from the lowest digit, the comparison reads every limb
+static void BM_Compare(benchmark::State& state) {
+  BigInt lhs = Operands(state.range(0), 1, false).first;
+  BigInt rhs = lhs + BigInt(1);
+  if (state.range(1) != 0) {
+    lhs = -lhs;
+    rhs = -rhs;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(lhs < rhs);
+    benchmark::DoNotOptimize(lhs == rhs);
+  }
+  SetDigits(state, state.range(0));
+}
+
+// kBatchSize random pairs of numbers of the given limbs and signs
+static std::pair<std::vector<BigInt>, std::vector<BigInt>> BatchOperands(
+    size_t limbs) {
+  std::mt19937_64 gen(limbs);
+  std::vector<BigInt> lhs;
+  std::vector<BigInt> rhs;
+  for (size_t k = 0; k < kBatchSize; ++k) {
+    std::vector<BigInt::Limb> left(limbs);
+    std::vector<BigInt::Limb> right(limbs);
+    std::generate(left.begin(), left.end(), gen);
+    std::generate(right.begin(), right.end(), gen);
+    lhs.emplace_back(gen() % 2 == 0, left);
+    rhs.emplace_back(gen() % 2 == 0, right);
+  }
+  return {lhs, rhs};
+}
+static void SetNumbers(benchmark::State& state) {
+  state.counters["numbers/s"] = benchmark::Counter(
+      double(kBatchSize), benchmark::Counter::kIsIterationInvariantRate);
+}
+// the per element loops are the baseline for the batches
+static void BM_ElementwiseAdd(benchmark::State& state) {
+  auto [lhs, rhs] = BatchOperands(state.range(0));
+  std::vector<BigInt> sums(kBatchSize);
+  for (auto _ : state) {
+    for (size_t k = 0; k < kBatchSize; ++k) {
+      sums[k] = lhs[k] + rhs[k];
+    }
+    benchmark::DoNotOptimize(sums.data());
+  }
+  SetNumbers(state);
+}
+static void BM_BatchAdd(benchmark::State& state) {
+  auto [lhs, rhs] = BatchOperands(state.range(0));
+  BigIntBatch left(lhs);
+  BigIntBatch right(rhs);
+  BigIntBatch sums;
+  for (auto _ : state) {
+    Add(sums, left, right);
+    benchmark::DoNotOptimize(sums);
+  }
+  SetNumbers(state);
+}
+static void BM_ElementwiseMul(benchmark::State& state) {
+  auto [lhs, rhs] = BatchOperands(state.range(0));
+  std::vector<BigInt> products(kBatchSize);
+  for (auto _ : state) {
+    for (size_t k = 0; k < kBatchSize; ++k) {
+      products[k] = lhs[k] * rhs[k];
+    }
+    benchmark::DoNotOptimize(products.data());
+  }
+  SetNumbers(state);
+}
+static void BM_BatchMul(benchmark::State& state) {
+  auto [lhs, rhs] = BatchOperands(state.range(0));
+  BigIntBatch left(lhs);
+  BigIntBatch right(rhs);
+  BigIntBatch products;
+  for (auto _ : state) {
+    Mul(products, left, right);
+    benchmark::DoNotOptimize(products);
+  }
+  SetNumbers(state);
+}
+
+static void DigitsOnly(benchmark::internal::Benchmark* bench) {
+  bench->ArgName("digits")->RangeMultiplier(10)->Range(kMinDigits, kMaxDigits);
+}
+// the mixed flag selects operands of opposite signs, for comparisons two
+// negative numbers
+static void DigitsAndSigns(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"digits", "mixed"});
+  for (int64_t digits = kMinDigits; digits <= kMaxDigits; digits *= 10) {
+    bench->Args({digits, 0})->Args({digits, 1});
+  }
+}
+
+BENCHMARK(BM_FromString)->Apply(DigitsOnly)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ToString)->Apply(DigitsOnly)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Add)->Apply(DigitsAndSigns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Sub)->Apply(DigitsAndSigns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AddAssign)->Apply(DigitsAndSigns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Mul)->Apply(DigitsAndSigns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Div)->Apply(DigitsAndSigns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Mod)->Apply(DigitsAndSigns)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Compare)->Apply(DigitsAndSigns)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_ElementwiseAdd)
+    ->ArgName("limbs")
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxBatchLimbs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BatchAdd)
+    ->ArgName("limbs")
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxBatchLimbs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ElementwiseMul)
+    ->ArgName("limbs")
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxBatchLimbs)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BatchMul)
+    ->ArgName("limbs")
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxBatchLimbs)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
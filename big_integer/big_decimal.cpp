@@ -0,0 +1,195 @@
+#include "big_decimal.hpp"
+
+#include <algorithm>
+#include <array>
+
+using Limb = BigInt::Limb;
+
+// 10^19 is the largest power of ten in a limb
+static const size_t kLimbDigits = 19;
+
+BigInt PowerOfTen(size_t exp) {
+  static const std::array<Limb, kLimbDigits + 1> kSmall = [] {
+    std::array<Limb, kLimbDigits + 1> powers;
+    powers[0] = 1;
+    for (size_t k = 1; k <= kLimbDigits; ++k) {
+      powers[k] = powers[k - 1] * 10;
+    }
+    return powers;
+  }();
+  BigInt result(std::vector<Limb>{kSmall[exp % kLimbDigits]});
+  BigInt square(std::vector<Limb>{kSmall[kLimbDigits]});
+  for (exp /= kLimbDigits; exp != 0; exp >>= 1) {
+    if ((exp & 1) != 0) {
+      result *= square;
+    }
+    if (exp > 1) {
+      square *= square;
+    }
+  }
+  return result;
+}
+BigInt DivRound(const BigInt& num, const BigInt& den, Rounding rounding) {
+  if (den == BigInt(0)) {
+    return BigInt(0);
+  }
+  auto [quot, rem] = num.DivMod(den);
+  if (rem == BigInt(0)) {
+    return quot;
+  }
+  // the exact quotient lies strictly between quot and quot + step
+  bool negative = (num < BigInt(0)) != (den < BigInt(0));
+  bool away = false;
+  if (rounding == Rounding::kFloor) {
+    away = negative;
+  } else if (rounding == Rounding::kCeiling) {
+    away = !negative;
+  } else if (rounding != Rounding::kTowardZero) {
+    BigInt twice = (rem < BigInt(0) ? -rem : rem) << 1;
+    BigInt abs_den = den < BigInt(0) ? -den : den;
+    away = abs_den < twice ||
+           (twice == abs_den &&
+            (rounding == Rounding::kHalfUp || quot.TestBit(0)));
+  }
+  if (away) {
+    quot += BigInt(negative ? -1 : 1);
+  }
+  return quot;
+}
+
+BigDecimal::BigDecimal(int64_t num) : mantissa_(num) {}
+BigDecimal::BigDecimal(const BigInt& num) : mantissa_(num) {}
+BigDecimal::BigDecimal(const BigInt& mantissa, size_t scale)
+    : mantissa_(mantissa), scale_(scale) {}
+BigDecimal::BigDecimal(const std::string& number) {
+  size_t point = number.find('.');
+  if (point == std::string::npos) {
+    mantissa_ = BigInt(number);
+    return;
+  }
+  mantissa_ = BigInt(number.substr(0, point) + number.substr(point + 1));
+  scale_ = number.size() - point - 1;
+}
+BigDecimal::BigDecimal(const BigRational& value, size_t scale,
+                       Rounding rounding)
+    : scale_(scale) {
+  BigRational reduced = value.Reduced();
+  mantissa_ = DivRound(reduced.Numerator() * PowerOfTen(scale),
+                       reduced.Denominator(), rounding);
+}
+BigInt BigDecimal::MantissaAt(size_t scale) const {
+  if (scale == scale_ || mantissa_ == BigInt(0)) {
+    return mantissa_;
+  }
+  return mantissa_ * PowerOfTen(scale - scale_);
+}
+BigDecimal BigDecimal::Rescale(size_t scale, Rounding rounding) const {
+  if (scale >= scale_) {
+    return BigDecimal(MantissaAt(scale), scale);
+  }
+  return BigDecimal(DivRound(mantissa_, PowerOfTen(scale_ - scale), rounding),
+                    scale);
+}
+// trailing zeros come off a limb worth of digits at a time while the
+// mantissa divides by 10^19
+BigDecimal BigDecimal::Trimmed() const {
+  if (mantissa_ == BigInt(0)) {
+    return BigDecimal();
+  }
+  BigInt mantissa = mantissa_;
+  size_t scale = scale_;
+  for (size_t digits : {kLimbDigits, size_t(1)}) {
+    BigInt power = PowerOfTen(digits);
+    while (scale >= digits) {
+      auto [quot, rem] = mantissa.DivMod(power);
+      if (rem != BigInt(0)) {
+        break;
+      }
+      mantissa = std::move(quot);
+      scale -= digits;
+    }
+  }
+  return BigDecimal(mantissa, scale);
+}
+BigRational BigDecimal::ToRational() const {
+  return BigRational(mantissa_, PowerOfTen(scale_));
+}
+
+/* arithmetic */
+BigDecimal BigDecimal::operator+(const BigDecimal& num) const {
+  size_t scale = std::max(scale_, num.scale_);
+  return BigDecimal(MantissaAt(scale) + num.MantissaAt(scale), scale);
+}
+BigDecimal BigDecimal::operator-(const BigDecimal& num) const {
+  size_t scale = std::max(scale_, num.scale_);
+  return BigDecimal(MantissaAt(scale) - num.MantissaAt(scale), scale);
+}
+BigDecimal BigDecimal::operator*(const BigDecimal& num) const {
+  return BigDecimal(mantissa_ * num.mantissa_, scale_ + num.scale_);
+}
+BigDecimal BigDecimal::operator-() const {
+  return BigDecimal(-mantissa_, scale_);
+}
+BigDecimal& BigDecimal::operator+=(const BigDecimal& num) {
+  return *this = *this + num;
+}
+BigDecimal& BigDecimal::operator-=(const BigDecimal& num) {
+  return *this = *this - num;
+}
+BigDecimal& BigDecimal::operator*=(const BigDecimal& num) {
+  return *this = *this * num;
+}
+// lhs / rhs * 10^scale = lhs.mantissa * 10^(scale + rhs.scale - lhs.scale)
+// / rhs.mantissa, the power of ten goes to whichever side keeps it whole
+BigDecimal BigDecimal::Divide(const BigDecimal& num, size_t scale,
+                              Rounding rounding) const {
+  if (num.mantissa_ == BigInt(0)) {
+    return BigDecimal(BigInt(0), scale);
+  }
+  size_t up = scale + num.scale_;
+  BigInt lhs = up >= scale_ ? mantissa_ * PowerOfTen(up - scale_) : mantissa_;
+  BigInt rhs = up >= scale_ ? num.mantissa_
+                            : num.mantissa_ * PowerOfTen(scale_ - up);
+  return BigDecimal(DivRound(lhs, rhs, rounding), scale);
+}
+
+/* comparison and output */
+int BigDecimal::Compare(const BigDecimal& num) const {
+  size_t scale = std::max(scale_, num.scale_);
+  BigInt lhs = MantissaAt(scale);
+  BigInt rhs = num.MantissaAt(scale);
+  return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+bool BigDecimal::operator==(const BigDecimal& num) const {
+  return Compare(num) == 0;
+}
+bool BigDecimal::operator!=(const BigDecimal& num) const {
+  return Compare(num) != 0;
+}
+bool BigDecimal::operator<(const BigDecimal& num) const {
+  return Compare(num) < 0;
+}
+bool BigDecimal::operator>(const BigDecimal& num) const {
+  return Compare(num) > 0;
+}
+bool BigDecimal::operator<=(const BigDecimal& num) const {
+  return Compare(num) <= 0;
+}
+bool BigDecimal::operator>=(const BigDecimal& num) const {
+  return Compare(num) >= 0;
+}
+std::string BigDecimal::ToString() const {
+  bool negative = mantissa_ < BigInt(0);
+  std::string digits = (negative ? -mantissa_ : mantissa_).ToString();
+  if (scale_ == 0) {
+    return (negative ? "-" : "") + digits;
+  }
+  if (digits.size() <= scale_) {
+    digits.insert(0, scale_ + 1 - digits.size(), '0');
+  }
+  digits.insert(digits.size() - scale_, 1, '.');
+  return (negative ? "-" : "") + digits;
+}
+std::ostream& operator<<(std::ostream& os, const BigDecimal& out) {
+  return os << out.ToString();
+}
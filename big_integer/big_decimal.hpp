@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "big_integer.hpp"
+#include "big_rational.hpp"
+// how results that do not fit the requested scale are rounded, the half
+// modes go to the nearest value and differ only on ties
+enum class Rounding { kTowardZero, kFloor, kCeiling, kHalfUp, kHalfEven };
+
+// fixed-point decimal mantissa / 10^scale; addition, subtraction and
+// multiplication are exact and take the scale they need, division and
+// Rescale round to a scale chosen by the caller
+class BigDecimal {
+ public:
+  BigDecimal() = default;
+  BigDecimal(int64_t num);
+  BigDecimal(const BigInt& num);
+  BigDecimal(const BigInt& mantissa, size_t scale);
+  // [-]digits[.digits], the scale is the number of digits after the point
+  explicit BigDecimal(const std::string& number);
+  // value rounded to scale digits after the point by one division
+  BigDecimal(const BigRational& value, size_t scale,
+             Rounding rounding = Rounding::kHalfEven);
+  const BigInt& Mantissa() const { return mantissa_; }
+  size_t Scale() const { return scale_; }
+  BigDecimal Rescale(size_t scale,
+                     Rounding rounding = Rounding::kHalfEven) const;
+  // without trailing zeros after the point
+  BigDecimal Trimmed() const;
+  BigRational ToRational() const;
+
+  BigDecimal operator+(const BigDecimal& num) const;
+  BigDecimal operator-(const BigDecimal& num) const;
+  BigDecimal operator*(const BigDecimal& num) const;
+  BigDecimal operator-() const;
+  BigDecimal& operator+=(const BigDecimal& num);
+  BigDecimal& operator-=(const BigDecimal& num);
+  BigDecimal& operator*=(const BigDecimal& num);
+  // quotient at the given scale, zero when num is zero; a DecimalExpansion
+  // of the quotient as a BigRational gives its digits one at a time instead
+  BigDecimal Divide(const BigDecimal& num, size_t scale,
+                    Rounding rounding = Rounding::kHalfEven) const;
+  // by value, so 1.50 == 1.5
+  bool operator==(const BigDecimal& num) const;
+  bool operator!=(const BigDecimal& num) const;
+  bool operator<(const BigDecimal& num) const;
+  bool operator>(const BigDecimal& num) const;
+  bool operator<=(const BigDecimal& num) const;
+  bool operator>=(const BigDecimal& num) const;
+  // all Scale() digits after the point
+  std::string ToString() const;
+  friend std::ostream& operator<<(std::ostream& os, const BigDecimal& out);
+
+ private:
+  // mantissa scaled to scale >= scale_ digits
+  BigInt MantissaAt(size_t scale) const;
+  int Compare(const BigDecimal& num) const;
+
+  BigInt mantissa_;
+  size_t scale_ = 0;
+};
+// 10^exp
+BigInt PowerOfTen(size_t exp);
+// num / den rounded to an integer, zero for a zero den
+BigInt DivRound(const BigInt& num, const BigInt& den, Rounding rounding);
@@ -1,50 +1,1188 @@
 #include "big_integer.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "limb_kernels.hpp"
+#include "scratch_arena.hpp"
 #include "string.h"
-BigInt::BigInt(bool is_neg, const std::vector<size_t>& number) {
-  sign_ = is_neg;
-  for (size_t i = 0; i < number.size(); ++i) {
-    this->number_.push_back(number[i]);
+#include "thread_pool.hpp"
+
+using Limb = BigInt::Limb;
+__extension__ using DoubleLimb = unsigned __int128;
+__extension__ using SignedDoubleLimb = __int128;
+
+static const size_t kLimbBits = 64;
+// largest power of ten that fits into one limb, used only for text I/O
+static const Limb kDecimalBase = 10000000000000000000ULL;
+static const size_t kDecimalDigits = 19;
+static const Limb kTen = 10;
+
+static const Limb kTopBit = Limb(1) << (kLimbBits - 1);
+static const Limb kInverse3 = 0xAAAAAAAAAAAAAAABULL;  // 3 * kInverse3 == 1
+// the transform size of 2^23 divides p - 1 of every prime, and 2^22 products
+// of 32-bit pieces stay below p1 * p2 * p3
+static const size_t kMaxNttSize = size_t(1) << 23;
+static const size_t kPieceBits = 32;
+static const uint64_t kPieceMask = 0xFFFFFFFFULL;
+static const uint32_t kNttMod1 = 998244353;
+static const uint32_t kNttMod2 = 167772161;
+static const uint32_t kNttMod3 = 469762049;
+static const uint64_t kNttRoot = 3;
+// divisor and quotient sizes in limbs from which division multiplies by a
+// Newton reciprocal instead of running Knuth's algorithm D
+static const size_t kNewtonThreshold = 2500;
+// numbers up to this many limbs are converted to and from decimal chunk by
+// chunk, larger ones are split by the cached powers 10^(19 * 2^k)
+static const size_t kRadixThreshold = 30;
+// smallest number of butterflies or pieces a parallel transform hands out
+static const size_t kNttGrain = size_t(1) << 14;
+
+BigInt::MulThresholds BigInt::mul_thresholds = {32, 200, 50000};
+BigInt::ThreadOptions BigInt::thread_options = {0, 2048};
+
+static void StripZeros(LimbVector& number) {
+  while (!number.empty() && number.back() == 0) {
+    number.pop_back();
+  }
+}
+// length of num[0..n) without its leading zero limbs
+static size_t Stripped(const Limb* num, size_t n) {
+  while (n > 0 && num[n - 1] == 0) {
+    --n;
+  }
+  return n;
+}
+static int CompareAbs(const Limb* lhs, size_t ln, const Limb* rhs, size_t rn) {
+  if (ln != rn) {
+    return ln < rn ? -1 : 1;
+  }
+  return LimbCompareN(lhs, rhs, ln);
+}
+static int CompareAbs(const LimbVector& lhs,
+                      const LimbVector& rhs) {
+  return CompareAbs(lhs.data(), lhs.size(), rhs.data(), rhs.size());
+}
+/* limb span kernels, result may alias the first operand */
+// res[0..n) = lhs[0..n) + carry, returns carry out
+static Limb AddLimb(Limb* res, const Limb* lhs, size_t n, Limb carry) {
+  for (size_t i = 0; i < n; ++i) {
+    res[i] = lhs[i] + carry;
+    carry = (res[i] < carry) ? 1 : 0;
+  }
+  return carry;
+}
+// res[0..n) = lhs[0..n) - borrow, returns borrow out
+static Limb SubLimb(Limb* res, const Limb* lhs, size_t n, Limb borrow) {
+  for (size_t i = 0; i < n; ++i) {
+    Limb cur = lhs[i];
+    res[i] = cur - borrow;
+    borrow = (cur < borrow) ? 1 : 0;
+  }
+  return borrow;
+}
+// the n-limb kernels below run on the vector units when the CPU has them
+static Limb AddN(Limb* res, const Limb* lhs, const Limb* rhs, size_t n) {
+  return LimbAddN(res, lhs, rhs, n);
+}
+static Limb SubN(Limb* res, const Limb* lhs, const Limb* rhs, size_t n) {
+  return LimbSubN(res, lhs, rhs, n);
+}
+// res[0..ln) = lhs + rhs, ln >= rn
+static Limb Add(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                size_t rn) {
+  Limb carry = AddN(res, lhs, rhs, rn);
+  return AddLimb(res + rn, lhs + rn, ln - rn, carry);
+}
+// res[0..ln) = lhs - rhs, ln >= rn
+static Limb Sub(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                size_t rn) {
+  Limb borrow = SubN(res, lhs, rhs, rn);
+  return SubLimb(res + rn, lhs + rn, ln - rn, borrow);
+}
+// res[0..n) = lhs[0..n) * mult, returns the high limb
+static Limb MulLimb(Limb* res, const Limb* lhs, size_t n, Limb mult) {
+  return LimbMulWord(res, lhs, n, mult);
+}
+// res[0..n) += lhs[0..n) * mult, returns the high limb
+static Limb AddMulLimb(Limb* res, const Limb* lhs, size_t n, Limb mult) {
+  Limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    DoubleLimb cur = DoubleLimb(lhs[i]) * mult + res[i] + carry;
+    res[i] = Limb(cur);
+    carry = Limb(cur >> kLimbBits);
   }
+  return carry;
 }
-BigInt::BigInt(const std::vector<size_t>& number) {
-  for (size_t i = 0; i < number.size(); ++i) {
-    this->number_.push_back(number[i]);
+// res[0..n) -= lhs[0..n) * mult, returns the borrow out of the top limb
+static Limb SubMulLimb(Limb* res, const Limb* lhs, size_t n, Limb mult) {
+  Limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    DoubleLimb cur = DoubleLimb(lhs[i]) * mult + carry;
+    Limb low = Limb(cur);
+    carry = Limb(cur >> kLimbBits) + ((res[i] < low) ? 1 : 0);
+    res[i] -= low;
+  }
+  return carry;
+}
+// res[0..n) = src << shift for 0 <= shift < 64, returns the bits shifted out
+static Limb ShiftLeftBits(Limb* res, const Limb* src, size_t n, size_t shift) {
+  if (shift == 0) {
+    std::copy(src, src + n, res);
+    return 0;
+  }
+  Limb out = src[n - 1] >> (kLimbBits - shift);
+  for (size_t i = n - 1; i > 0; --i) {
+    res[i] = (src[i] << shift) | (src[i - 1] >> (kLimbBits - shift));
+  }
+  res[0] = src[0] << shift;
+  return out;
+}
+// res[0..n) = src >> shift for 0 <= shift < 64
+static void ShiftRightBits(Limb* res, const Limb* src, size_t n,
+                           size_t shift) {
+  if (shift == 0) {
+    std::copy(src, src + n, res);
+    return;
   }
+  for (size_t i = 0; i + 1 < n; ++i) {
+    res[i] = (src[i] >> shift) | (src[i + 1] << (kLimbBits - shift));
+  }
+  res[n - 1] = src[n - 1] >> shift;
+}
+// res[0..ln) = |lhs - rhs|, ln >= rn, returns true if lhs < rhs
+static bool AbsDiff(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                    size_t rn) {
+  size_t top = ln;
+  while (top > rn && lhs[top - 1] == 0) {
+    --top;
+  }
+  if (top == rn && CompareAbs(lhs, rn, rhs, rn) < 0) {
+    SubN(res, rhs, lhs, rn);
+    std::fill(res + rn, res + ln, 0);
+    return true;
+  }
+  Sub(res, lhs, ln, rhs, rn);
+  return false;
 }
-BigInt::BigInt(int64_t number) {
-  if (number == 0) {
-    this->number_.push_back(0);
+/* parallel execution */
+static std::shared_ptr<ThreadPool> AcquirePool() {
+  return ThreadPool::Shared(BigInt::thread_options.max_threads);
+}
+static bool RunsParallel(size_t rn) {
+  return ThreadPool::Current() != nullptr &&
+         rn >= BigInt::thread_options.min_limbs;
+}
+/* multiplication engine, res must not overlap the operands */
+static void MulLimbs(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                     size_t rn, Limb* scratch);
+static size_t MulScratchSize(size_t ln, size_t rn);
+// runs the product right away, or on the pool with scratch of its own
+static void MulBranch(TaskGroup* group, Limb* res, const Limb* lhs, size_t ln,
+                      const Limb* rhs, size_t rn, Limb* scratch) {
+  if (group == nullptr) {
+    MulLimbs(res, lhs, ln, rhs, rn, scratch);
+    return;
+  }
+  group->Run([=] {
+    ScratchArena::Frame frame;
+    MulLimbs(res, lhs, ln, rhs, rn,
+             frame.Allocate<Limb>(MulScratchSize(ln, rn)));
+  });
+}
+// res[0..ln + rn) = lhs * rhs
+static void MulSchoolbook(Limb* res, const Limb* lhs, size_t ln,
+                          const Limb* rhs, size_t rn) {
+  res[ln] = MulLimb(res, lhs, ln, rhs[0]);
+  for (size_t i = 1; i < rn; ++i) {
+    res[ln + i] = AddMulLimb(res + i, lhs, ln, rhs[i]);
+  }
+}
+// ln >= rn, lhs is cut into rn-sized chunks so that every product is
+// balanced, the chunk products are accumulated in res
+static void MulChunked(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                       size_t rn, Limb* scratch) {
+  MulLimbs(res, lhs, rn, rhs, rn, scratch);
+  std::fill(res + 2 * rn, res + ln + rn, 0);
+  Limb* chunk = scratch;
+  scratch += 2 * rn;
+  for (size_t offset = rn; offset < ln; offset += rn) {
+    size_t len = std::min(rn, ln - offset);
+    MulLimbs(chunk, rhs, rn, lhs + offset, len, scratch);
+    Add(res + offset, res + offset, ln + rn - offset, chunk, len + rn);
+  }
+}
+// ln >= rn > (ln + 1) / 2, lhs = a1 * B^m + a0, rhs = b1 * B^m + b0,
+// the middle term is a0 * b0 + a1 * b1 - (a0 - a1) * (b0 - b1)
+static void MulKaratsuba(Limb* res, const Limb* lhs, size_t ln,
+                         const Limb* rhs, size_t rn, Limb* scratch) {
+  size_t half = (ln + 1) / 2;
+  size_t total = ln + rn;
+  std::optional<TaskGroup> group;
+  if (RunsParallel(rn)) {
+    group.emplace(*ThreadPool::Current());
+  }
+  TaskGroup* tasks = group ? &*group : nullptr;
+  MulBranch(tasks, res, lhs, half, rhs, half, scratch);
+  MulBranch(tasks, res + 2 * half, lhs + half, ln - half, rhs + half,
+            rn - half, scratch);
+  Limb* diff_lhs = scratch;
+  Limb* diff_rhs = scratch + half;
+  Limb* middle = scratch + 2 * half;
+  Limb* sum = scratch + 4 * half;
+  bool negative = AbsDiff(diff_lhs, lhs, half, lhs + half, ln - half);
+  negative ^= AbsDiff(diff_rhs, rhs, half, rhs + half, rn - half);
+  MulLimbs(middle, diff_lhs, half, diff_rhs, half, sum);
+  if (group) {
+    group->Wait();
+  }
+  sum[2 * half] = Add(sum, res, 2 * half, res + 2 * half, total - 2 * half);
+  if (negative) {
+    Add(sum, sum, 2 * half + 1, middle, 2 * half);
+  } else {
+    Sub(sum, sum, 2 * half + 1, middle, 2 * half);
+  }
+  size_t len = std::min(2 * half + 1, total - half);
+  Add(res + half, res + half, total - half, sum, len);
+}
+/* two's complement helpers for the Toom-3 interpolation */
+static void Negate(Limb* res, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    res[i] = ~res[i];
+  }
+  AddLimb(res, res, n, 1);
+}
+static void HalveSigned(Limb* res, size_t n) {
+  for (size_t i = 0; i + 1 < n; ++i) {
+    res[i] = (res[i] >> 1) | (res[i + 1] << (kLimbBits - 1));
+  }
+  res[n - 1] = (res[n - 1] >> 1) | (res[n - 1] & kTopBit);
+}
+// res is a multiple of 3 modulo B^n
+static void DivExact3(Limb* res, size_t n) {
+  Limb borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    Limb cur = res[i] - borrow;
+    borrow = (res[i] < borrow) ? 1 : 0;
+    res[i] = cur * kInverse3;
+    borrow += Limb((DoubleLimb(res[i]) * 3) >> kLimbBits);
+  }
+}
+// num = a2 * x^2 + a1 * x + a0 with k-limb parts, at_one = num(1) and
+// at_minus_one = |num(-1)| take k + 1 limbs, returns true if num(-1) < 0
+static bool Toom3EvalOnes(Limb* at_one, Limb* at_minus_one, const Limb* num,
+                          size_t n, size_t k) {
+  at_minus_one[k] = Add(at_minus_one, num, k, num + 2 * k, n - 2 * k);
+  Add(at_one, at_minus_one, k + 1, num + k, k);
+  return AbsDiff(at_minus_one, at_minus_one, k + 1, num + k, k);
+}
+// res = |num(-2)| = |a0 + 4 * a2 - 2 * a1|, tmp takes k + 1 limbs
+static bool Toom3EvalMinusTwo(Limb* res, Limb* tmp, const Limb* num, size_t n,
+                              size_t k) {
+  size_t high = n - 2 * k;
+  std::copy(num, num + k, res);
+  res[k] = 0;
+  Limb carry = AddMulLimb(res, num + 2 * k, high, 4);
+  AddLimb(res + high, res + high, k + 1 - high, carry);
+  tmp[k] = MulLimb(tmp, num + k, k, 2);
+  return AbsDiff(res, res, k + 1, tmp, k + 1);
+}
+// ln >= rn > 2 * k, both operands are split into three k-limb parts and
+// evaluated at 0, 1, -1, -2 and infinity; the interpolation runs on
+// 2k + 2 limb two's complement values, which is wide enough for every
+// intermediate result; in parallel all evaluations are made up front so
+// that the five products can run at once
+static void MulToom3(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                     size_t rn, Limb* scratch) {
+  size_t k = (ln + 2) / 3;
+  size_t width = 2 * k + 2;
+  size_t total = ln + rn;
+  size_t inf_len = total - 4 * k;
+  Limb* at_inf = res + 4 * k;
+  std::optional<TaskGroup> group;
+  if (RunsParallel(rn)) {
+    group.emplace(*ThreadPool::Current());
+  }
+  TaskGroup* tasks = group ? &*group : nullptr;
+  MulBranch(tasks, res, lhs, k, rhs, k, scratch);
+  MulBranch(tasks, at_inf, lhs + 2 * k, ln - 2 * k, rhs + 2 * k, rn - 2 * k,
+            scratch);
+  Limb* at_one = scratch;
+  Limb* at_minus_one = scratch + width;
+  Limb* at_minus_two = scratch + 2 * width;
+  Limb* eval_lhs = scratch + 3 * width;
+  Limb* eval_rhs = eval_lhs + k + 1;
+  Limb* inner = eval_rhs + k + 1;
+  ScratchArena::Frame frame;
+  Limb* minus_one_lhs =
+      group ? frame.Allocate<Limb>(4 * (k + 1)) : at_minus_two;
+  Limb* minus_one_rhs = minus_one_lhs + k + 1;
+  Limb* minus_two_lhs = group ? minus_one_rhs + k + 1 : eval_lhs;
+  Limb* minus_two_rhs = minus_two_lhs + k + 1;
+  bool negative_one = Toom3EvalOnes(eval_lhs, minus_one_lhs, lhs, ln, k);
+  negative_one ^= Toom3EvalOnes(eval_rhs, minus_one_rhs, rhs, rn, k);
+  bool negative_two = false;
+  if (group) {
+    negative_two = Toom3EvalMinusTwo(minus_two_lhs, inner, lhs, ln, k);
+    negative_two ^= Toom3EvalMinusTwo(minus_two_rhs, inner, rhs, rn, k);
+  }
+  MulBranch(tasks, at_one, eval_lhs, k + 1, eval_rhs, k + 1, inner);
+  MulBranch(tasks, at_minus_one, minus_one_lhs, k + 1, minus_one_rhs, k + 1,
+            inner);
+  if (!group) {
+    negative_two = Toom3EvalMinusTwo(minus_two_lhs, inner, lhs, ln, k);
+    negative_two ^= Toom3EvalMinusTwo(minus_two_rhs, inner, rhs, rn, k);
+  }
+  MulBranch(tasks, at_minus_two, minus_two_lhs, k + 1, minus_two_rhs, k + 1,
+            inner);
+  if (group) {
+    group->Wait();
+  }
+  if (negative_one) {
+    Negate(at_minus_one, width);
+  }
+  if (negative_two) {
+    Negate(at_minus_two, width);
+  }
+  // r3 = (r(-2) - r(1)) / 3, r1 = (r(1) - r(-1)) / 2, r2 = r(-1) - r(0)
+  Sub(at_minus_two, at_minus_two, width, at_one, width);
+  DivExact3(at_minus_two, width);
+  Sub(at_one, at_one, width, at_minus_one, width);
+  HalveSigned(at_one, width);
+  Sub(at_minus_one, at_minus_one, width, res, 2 * k);
+  // r3 = (r2 - r3) / 2 + 2 * r(inf), r2 = r2 + r1 - r(inf), r1 = r1 - r3
+  Sub(at_minus_two, at_minus_one, width, at_minus_two, width);
+  HalveSigned(at_minus_two, width);
+  Add(at_minus_two, at_minus_two, width, at_inf, inf_len);
+  Add(at_minus_two, at_minus_two, width, at_inf, inf_len);
+  Add(at_minus_one, at_minus_one, width, at_one, width);
+  Sub(at_minus_one, at_minus_one, width, at_inf, inf_len);
+  Sub(at_one, at_one, width, at_minus_two, width);
+  std::fill(res + 2 * k, res + 4 * k, 0);
+  for (size_t i = 1; i < 4; ++i) {
+    const Limb* coef = scratch + (i - 1) * width;
+    Add(res + i * k, res + i * k, total - i * k, coef,
+        std::min(width, total - i * k));
+  }
+}
+/* three-prime number theoretic transform over 32-bit pieces of the limbs */
+static uint64_t PowMod(uint64_t base, uint64_t exp, uint64_t mod) {
+  uint64_t result = 1;
+  base %= mod;
+  for (; exp != 0; exp >>= 1) {
+    if ((exp & 1) != 0) {
+      result = result * base % mod;
+    }
+    base = base * base % mod;
+  }
+  return result;
+}
+// Montgomery multiplication modulo an NTT prime with R = 2^32
+static constexpr uint32_t NegInverse(uint32_t mod) {
+  uint32_t inv = mod;
+  for (size_t i = 0; i < 5; ++i) {
+    inv *= 2 - mod * inv;
+  }
+  return -inv;
+}
+template <uint32_t kMod>
+static uint32_t MontMul(uint32_t lhs, uint32_t rhs) {
+  constexpr uint32_t kNegInv = NegInverse(kMod);
+  uint64_t value = uint64_t(lhs) * rhs;
+  uint32_t factor = uint32_t(value) * kNegInv;
+  uint32_t result = (value + uint64_t(factor) * kMod) >> kPieceBits;
+  return (result >= kMod) ? result - kMod : result;
+}
+template <uint32_t kMod>
+static uint32_t ToMont(uint64_t value) {
+  return (value << kPieceBits) % kMod;
+}
+// roots[j] = w^j, j < size / 2, for a primitive size-th root of unity w in
+// Montgomery form
+template <uint32_t kMod>
+static void MakeRoots(uint32_t* roots, size_t size, bool inverse) {
+  uint64_t root = PowMod(kNttRoot, (kMod - 1) / size, kMod);
+  if (inverse) {
+    root = PowMod(root, kMod - 2, kMod);
+  }
+  uint32_t step = ToMont<kMod>(root);
+  ParallelFor(size / 2, kNttGrain, [&](size_t first, size_t last) {
+    uint32_t cur = ToMont<kMod>(PowMod(root, first, kMod));
+    for (size_t j = first; j < last; ++j) {
+      roots[j] = cur;
+      cur = MontMul<kMod>(cur, step);
+    }
+  });
+}
+// a stage of length len uses every (size / len)-th root, gathered into a
+// contiguous run
+static void StageRoots(uint32_t* stage, const uint32_t* roots, size_t size,
+                       size_t len) {
+  size_t stride = size / len;
+  ParallelFor(len / 2, kNttGrain, [&](size_t first, size_t last) {
+    for (size_t j = first; j < last; ++j) {
+      stage[j] = roots[j * stride];
+    }
+  });
+}
+// body runs on the pieces low[j], high[j] of one block with j in
+// [first, last), the work is split across the blocks of a short stage and
+// inside the blocks of a long one
+template <typename Body>
+static void ForEachButterfly(uint32_t* data, size_t size, size_t len,
+                             const Body& body) {
+  size_t half = len / 2;
+  if (half >= kNttGrain) {
+    for (size_t i = 0; i < size; i += len) {
+      uint32_t* low = data + i;
+      ParallelFor(half, kNttGrain, [&](size_t first, size_t last) {
+        body(low, low + half, first, last);
+      });
+    }
+    return;
+  }
+  ParallelFor(size / len, kNttGrain / half, [&](size_t first, size_t last) {
+    for (size_t i = first * len; i < last * len; i += len) {
+      body(data + i, data + i + half, 0, half);
+    }
+  });
+}
+// decimation in frequency, the output is left in bit-reversed order
+template <uint32_t kMod>
+static void NttForward(uint32_t* data, size_t size) {
+  ScratchArena::Frame frame;
+  uint32_t* roots = frame.Allocate<uint32_t>(size / 2);
+  uint32_t* stage = frame.Allocate<uint32_t>(size / 2);
+  MakeRoots<kMod>(roots, size, false);
+  for (size_t len = size; len >= 2; len >>= 1) {
+    StageRoots(stage, roots, size, len);
+    ForEachButterfly(data, size, len, [&](uint32_t* low, uint32_t* high,
+                                          size_t first, size_t last) {
+      for (size_t j = first; j < last; ++j) {
+        uint32_t u = low[j];
+        uint32_t v = high[j];
+        low[j] = (u + v >= kMod) ? u + v - kMod : u + v;
+        high[j] = MontMul<kMod>((u >= v) ? u - v : u + kMod - v,
+                                stage[j]);
+      }
+    });
+  }
+}
+// decimation in time from bit-reversed order back to the natural one
+template <uint32_t kMod>
+static void NttInverse(uint32_t* data, size_t size) {
+  ScratchArena::Frame frame;
+  uint32_t* roots = frame.Allocate<uint32_t>(size / 2);
+  uint32_t* stage = frame.Allocate<uint32_t>(size / 2);
+  MakeRoots<kMod>(roots, size, true);
+  for (size_t len = 2; len <= size; len <<= 1) {
+    StageRoots(stage, roots, size, len);
+    ForEachButterfly(data, size, len, [&](uint32_t* low, uint32_t* high,
+                                          size_t first, size_t last) {
+      for (size_t j = first; j < last; ++j) {
+        uint32_t u = low[j];
+        uint32_t v = MontMul<kMod>(high[j], stage[j]);
+        low[j] = (u + v >= kMod) ? u + v - kMod : u + v;
+        high[j] = (u >= v) ? u - v : u + kMod - v;
+      }
+    });
+  }
+}
+// pieces[0..size) holds the 32-bit halves of num reduced modulo kMod
+template <uint32_t kMod>
+static void ToPieces(uint32_t* pieces, const Limb* num, size_t n,
+                     size_t size) {
+  std::fill(pieces + 2 * n, pieces + size, 0);
+  ParallelFor(n, kNttGrain, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      pieces[2 * i] = (num[i] & kPieceMask) % kMod;
+      pieces[2 * i + 1] = (num[i] >> kPieceBits) % kMod;
+    }
+  });
+}
+template <uint32_t kMod>
+static void TransformPieces(uint32_t* pieces, const Limb* num, size_t n,
+                            size_t size) {
+  ToPieces<kMod>(pieces, num, n, size);
+  NttForward<kMod>(pieces, size);
+}
+// result[0..size) gets the cyclic convolution of the pieces, the pointwise
+// Montgomery product leaves a factor R^-1 which is cancelled together with
+// the 1 / size of the inverse transform
+template <uint32_t kMod>
+static void ConvolveMod(uint32_t* result, const Limb* lhs, size_t ln,
+                        const Limb* rhs, size_t rn, size_t size) {
+  ScratchArena::Frame frame;
+  bool square = lhs == rhs && ln == rn;
+  uint32_t* factor = result;
+  if (!square) {
+    factor = frame.Allocate<uint32_t>(size);
+    std::optional<TaskGroup> group;
+    if (ThreadPool::Current() != nullptr) {
+      group.emplace(*ThreadPool::Current());
+      group->Run([=] { TransformPieces<kMod>(factor, rhs, rn, size); });
+    } else {
+      TransformPieces<kMod>(factor, rhs, rn, size);
+    }
+    TransformPieces<kMod>(result, lhs, ln, size);
   } else {
-    if (number < 0) {
-      sign_ = false;
-      if (std::numeric_limits<int64_t>::min() == number) {
-        number = std::numeric_limits<int64_t>::max();
-        for (; number != 0; number /= kRank) {
-          int val = int64_t(number % kRank);
-          number_.push_back(val);
-        }
-        --*this;
+    TransformPieces<kMod>(result, lhs, ln, size);
+  }
+  ParallelFor(size, kNttGrain, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      result[i] = MontMul<kMod>(result[i], factor[i]);
+    }
+  });
+  NttInverse<kMod>(result, size);
+  uint64_t scale = PowMod(size, kMod - 2, kMod);
+  scale = ToMont<kMod>(ToMont<kMod>(scale));
+  ParallelFor(size, kNttGrain, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      result[i] = MontMul<kMod>(result[i], uint32_t(scale));
+    }
+  });
+}
+// Garner's reconstruction of the value below p1 * p2 * p3
+static DoubleLimb CrtCombine(uint64_t r1, uint64_t r2, uint64_t r3) {
+  static const uint64_t kInv12 = PowMod(kNttMod1, kNttMod2 - 2, kNttMod2);
+  static const uint64_t kInv13 = PowMod(kNttMod1, kNttMod3 - 2, kNttMod3);
+  static const uint64_t kInv23 = PowMod(kNttMod2, kNttMod3 - 2, kNttMod3);
+  uint64_t x2 = (r2 + kNttMod2 - r1 % kNttMod2) * kInv12 % kNttMod2;
+  uint64_t x3 = (r3 + kNttMod3 - r1 % kNttMod3) * kInv13 % kNttMod3;
+  x3 = (x3 + kNttMod3 - x2 % kNttMod3) * kInv23 % kNttMod3;
+  return r1 + DoubleLimb(x2) * kNttMod1 +
+         DoubleLimb(x3) * (uint64_t(kNttMod1) * kNttMod2);
+}
+static bool NttFits(size_t ln, size_t rn) {
+  return 2 * (ln + rn) <= kMaxNttSize;
+}
+static void MulNtt(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                   size_t rn) {
+  size_t size = 1;
+  while (size < 2 * (ln + rn)) {
+    size <<= 1;
+  }
+  ScratchArena::Frame frame;
+  uint32_t* first = frame.Allocate<uint32_t>(size);
+  uint32_t* second = frame.Allocate<uint32_t>(size);
+  uint32_t* third = frame.Allocate<uint32_t>(size);
+  {
+    std::optional<TaskGroup> group;
+    if (ThreadPool::Current() != nullptr) {
+      group.emplace(*ThreadPool::Current());
+    }
+    auto run = [&](auto convolve) {
+      if (group) {
+        group->Run(convolve);
       } else {
-        number = -number;
+        convolve();
+      }
+    };
+    run([=] { ConvolveMod<kNttMod1>(first, lhs, ln, rhs, rn, size); });
+    run([=] { ConvolveMod<kNttMod2>(second, lhs, ln, rhs, rn, size); });
+    ConvolveMod<kNttMod3>(third, lhs, ln, rhs, rn, size);
+  }
+  DoubleLimb carry = 0;
+  for (size_t i = 0; i < ln + rn; ++i) {
+    Limb limb = 0;
+    for (size_t j = 2 * i; j < 2 * i + 2; ++j) {
+      carry += CrtCombine(first[j], second[j], third[j]);
+      limb |= Limb(carry & kPieceMask) << ((j - 2 * i) * kPieceBits);
+      carry >>= kPieceBits;
+    }
+    res[i] = limb;
+  }
+}
+static void MulLimbs(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                     size_t rn, Limb* scratch) {
+  if (ln < rn) {
+    std::swap(lhs, rhs);
+    std::swap(ln, rn);
+  }
+  const BigInt::MulThresholds& thresholds = BigInt::mul_thresholds;
+  if (rn < 2 || rn < thresholds.karatsuba) {
+    MulSchoolbook(res, lhs, ln, rhs, rn);
+  } else if (rn >= thresholds.ntt && NttFits(ln, rn)) {
+    MulNtt(res, lhs, ln, rhs, rn);
+  } else if (2 * rn <= ln + 1) {
+    MulChunked(res, lhs, ln, rhs, rn, scratch);
+  } else if (rn >= thresholds.toom3 && rn > 2 * ((ln + 2) / 3)) {
+    MulToom3(res, lhs, ln, rhs, rn, scratch);
+  } else {
+    MulKaratsuba(res, lhs, ln, rhs, rn, scratch);
+  }
+}
+// a Karatsuba level of size n keeps 4 * ceil(n / 2) limbs while recursing
+// into a half and a Toom-3 level keeps 8 * ceil(n / 3) + 8, a chunked product
+// adds 2 * rn on top of a balanced one, so 6 limbs per operand limb plus the
+// rounding slack of every level suffice, schoolbook products need none
+static size_t MulScratchSize(size_t ln, size_t rn) {
+  size_t min = std::min(ln, rn);
+  if (min < 2 || min < BigInt::mul_thresholds.karatsuba) {
+    return 0;
+  }
+  return 6 * std::max(ln, rn) + 4 * kLimbBits;
+}
+static LimbVector AddAbs(const LimbVector& lhs,
+                                const LimbVector& rhs) {
+  if (lhs.size() < rhs.size()) {
+    return AddAbs(rhs, lhs);
+  }
+  LimbVector result(lhs.size() + 1);
+  result[lhs.size()] =
+      Add(result.data(), lhs.data(), lhs.size(), rhs.data(), rhs.size());
+  StripZeros(result);
+  return result;
+}
+// |lhs| >= |rhs|
+static LimbVector SubAbs(const LimbVector& lhs,
+                                const LimbVector& rhs) {
+  LimbVector result(lhs.size());
+  Sub(result.data(), lhs.data(), lhs.size(), rhs.data(), rhs.size());
+  StripZeros(result);
+  return result;
+}
+// number[0..n) = number * mult + add, returns the new length, number has
+// room for one more limb
+static size_t MulAddLimb(Limb* number, size_t n, Limb mult, Limb add) {
+  Limb carry = MulLimb(number, number, n, mult);
+  carry += AddLimb(number, number, n, add);
+  if (carry != 0) {
+    number[n++] = carry;
+  }
+  return n;
+}
+// number[0..n) /= div, returns remainder
+static Limb DivRemLimb(Limb* number, size_t n, Limb div) {
+  DoubleLimb rem = 0;
+  for (size_t i = n; i > 0; --i) {
+    DoubleLimb cur = (rem << kLimbBits) | number[i - 1];
+    number[i - 1] = Limb(cur / div);
+    rem = cur % div;
+  }
+  return Limb(rem);
+}
+static Limb DivRemLimb(LimbVector& number, Limb div) {
+  Limb rem = DivRemLimb(number.data(), number.size(), div);
+  StripZeros(number);
+  return rem;
+}
+// res[0..ln + rn) = lhs * rhs with the scratch taken from the arena, a
+// product started outside any pool enters the shared one when it is large
+// enough, the products inside it spread from there
+static void MulInto(Limb* res, const Limb* lhs, size_t ln, const Limb* rhs,
+                    size_t rn) {
+  if (ln == 0 || rn == 0) {
+    std::fill(res, res + ln + rn, 0);
+    return;
+  }
+  ScratchArena::Frame frame;
+  Limb* scratch = frame.Allocate<Limb>(MulScratchSize(ln, rn));
+  std::shared_ptr<ThreadPool> pool;
+  std::optional<ThreadPool::Scope> scope;
+  if (ThreadPool::Current() == nullptr &&
+      std::min(ln, rn) >= BigInt::thread_options.min_limbs) {
+    pool = AcquirePool();
+  }
+  if (pool) {
+    scope.emplace(pool.get());
+  }
+  MulLimbs(res, lhs, ln, rhs, rn, scratch);
+}
+static LimbVector MulAbs(const LimbVector& lhs,
+                                const LimbVector& rhs) {
+  if (lhs.empty() || rhs.empty()) {
+    return {};
+  }
+  LimbVector result(lhs.size() + rhs.size());
+  MulInto(result.data(), lhs.data(), lhs.size(), rhs.data(), rhs.size());
+  StripZeros(result);
+  return result;
+}
+/* division engine on limb spans, the temporaries live in the arena */
+// Knuth's algorithm D: num holds the normalized dividend with an extra top
+// limb and is left with the remainder, den is normalized (top bit set)
+static void DivKnuth(Limb* quot, Limb* num, size_t num_len, const Limb* den,
+                     size_t n) {
+  Limb top = den[n - 1];
+  Limb second = den[n - 2];
+  for (size_t j = num_len - n; j-- > 0;) {
+    DoubleLimb cur = (DoubleLimb(num[j + n]) << kLimbBits) | num[j + n - 1];
+    DoubleLimb qhat = cur / top;
+    DoubleLimb rhat = cur % top;
+    while ((qhat >> kLimbBits) != 0 ||
+           qhat * second > ((rhat << kLimbBits) | num[j + n - 2])) {
+      --qhat;
+      rhat += top;
+      if ((rhat >> kLimbBits) != 0) {
+        break;
       }
     }
-    for (; number != 0; number /= kRank) {
-      int val = int64_t(number % kRank);
-      number_.push_back(val);
+    Limb borrow = SubMulLimb(num + j, den, n, Limb(qhat));
+    Limb prev = num[j + n];
+    num[j + n] = prev - borrow;
+    if (prev < borrow) {
+      --qhat;
+      num[j + n] += AddN(num + j, num + j, den, n);
     }
+    quot[j] = Limb(qhat);
   }
 }
-BigInt::BigInt(bool sign, int64_t number) {
-  if (number == 0) {
-    this->number_.push_back(0);
+// approximation of B^(2n) / den for a normalized n-limb den, off by a few
+// units: the reciprocal of the top n / 2 + 1 limbs is refined by one Newton
+// step x += x * (B^(2n) - den * x) / B^(2n); recip has room for n + 2 limbs,
+// returns its length
+static size_t Reciprocal(const Limb* den, size_t n, Limb* recip) {
+  ScratchArena::Frame frame;
+  if (n <= kNewtonThreshold) {
+    Limb* power = frame.Allocate<Limb>(2 * n + 2);
+    std::fill(power, power + 2 * n + 2, 0);
+    power[2 * n] = 1;
+    DivKnuth(recip, power, 2 * n + 2, den, n);
+    return Stripped(recip, n + 2);
+  }
+  size_t high = n / 2 + 1;
+  Limb* approx = frame.Allocate<Limb>(n + 2);
+  std::fill(approx, approx + n - high, 0);
+  size_t an = n - high + Reciprocal(den + n - high, high, approx + n - high);
+  Limb* error = frame.Allocate<Limb>(std::max(n + an, 2 * n));
+  MulInto(error, den, n, approx, an);
+  size_t en = Stripped(error, n + an);
+  bool below = en <= 2 * n;
+  if (below) {
+    std::fill(error + en, error + 2 * n, 0);
+    Negate(error, 2 * n);
+    en = Stripped(error, 2 * n);
   } else {
-    sign_ = sign;
-    for (; number != 0; number /= kRank) {
-      int val = int64_t(number % kRank);
-      number_.push_back(val);
+    SubLimb(error + 2 * n, error + 2 * n, en - 2 * n, 1);
+    en = Stripped(error, en);
+  }
+  Limb* step = frame.Allocate<Limb>(an + en);
+  MulInto(step, approx, an, error, en);
+  size_t sn = Stripped(step, an + en);
+  sn = (sn > 2 * n) ? sn - 2 * n : 0;
+  std::copy(approx, approx + an, recip);
+  if (below) {
+    recip[an] = Add(recip, recip, an, step + 2 * n, sn);
+    return Stripped(recip, an + 1);
+  }
+  Sub(recip, recip, an, step + 2 * n, sn);
+  return Stripped(recip, an);
+}
+// num < den * B^n with nn <= 2n limbs, the quotient estimate
+// num * recip / B^(2n) is corrected by a few additions or subtractions of
+// den; quot gets n limbs and rem gets n limbs
+static void DivChunk(const Limb* num, size_t nn, const Limb* den, size_t n,
+                     const Limb* recip, size_t rn, Limb* quot, Limb* rem) {
+  ScratchArena::Frame frame;
+  Limb* estimate = frame.Allocate<Limb>(nn + rn);
+  MulInto(estimate, num, nn, recip, rn);
+  size_t en = Stripped(estimate, nn + rn);
+  Limb* cur_quot = frame.Allocate<Limb>(n + 2);
+  std::fill(cur_quot, cur_quot + n + 2, 0);
+  size_t qn = (en > 2 * n) ? en - 2 * n : 0;
+  std::copy(estimate + 2 * n, estimate + 2 * n + qn, cur_quot);
+  Limb* product = frame.Allocate<Limb>(qn + n);
+  MulInto(product, cur_quot, qn, den, n);
+  size_t pn = Stripped(product, qn + n);
+  while (CompareAbs(product, pn, num, nn) > 0) {
+    SubLimb(cur_quot, cur_quot, n + 2, 1);
+    Sub(product, product, pn, den, n);
+    pn = Stripped(product, pn);
+  }
+  Limb* cur_rem = frame.Allocate<Limb>(nn);
+  Sub(cur_rem, num, nn, product, pn);
+  size_t cn = Stripped(cur_rem, nn);
+  while (CompareAbs(cur_rem, cn, den, n) >= 0) {
+    AddLimb(cur_quot, cur_quot, n + 2, 1);
+    Sub(cur_rem, cur_rem, cn, den, n);
+    cn = Stripped(cur_rem, cn);
+  }
+  std::copy(cur_quot, cur_quot + n, quot);
+  std::copy(cur_rem, cur_rem + cn, rem);
+  std::fill(rem + cn, rem + n, 0);
+}
+// the normalized dividend is consumed in n-limb blocks from the top, every
+// block is divided by one reciprocal multiplication; quot gets nn rounded
+// up to whole blocks and rem gets n limbs
+static void DivNewton(const Limb* num, size_t nn, const Limb* den, size_t n,
+                      Limb* quot, Limb* rem) {
+  ScratchArena::Frame frame;
+  Limb* recip = frame.Allocate<Limb>(n + 2);
+  size_t rn = Reciprocal(den, n, recip);
+  Limb* cur = frame.Allocate<Limb>(2 * n);
+  std::fill(rem, rem + n, 0);
+  for (size_t i = (nn + n - 1) / n; i-- > 0;) {
+    size_t len = std::min(nn, (i + 1) * n) - i * n;
+    std::copy(num + i * n, num + i * n + len, cur);
+    std::fill(cur + len, cur + n, 0);
+    std::copy(rem, rem + n, cur + n);
+    DivChunk(cur, Stripped(cur, 2 * n), den, n, recip, rn, quot + i * n, rem);
+  }
+}
+// nn >= dn > 0 and den[dn - 1] != 0, quot gets nn - dn + 2 limbs and rem
+// gets dn limbs, both with leading zeros
+static void DivModLimbs(const Limb* num, size_t nn, const Limb* den,
+                        size_t dn, Limb* quot, Limb* rem) {
+  std::fill(quot, quot + nn - dn + 2, 0);
+  if (dn == 1) {
+    std::copy(num, num + nn, quot);
+    rem[0] = DivRemLimb(quot, nn, den[0]);
+    return;
+  }
+  ScratchArena::Frame frame;
+  size_t shift = std::countl_zero(den[dn - 1]);
+  Limb* norm_den = frame.Allocate<Limb>(dn);
+  ShiftLeftBits(norm_den, den, dn, shift);
+  Limb* norm_num = frame.Allocate<Limb>(nn + 2);
+  norm_num[nn] = ShiftLeftBits(norm_num, num, nn, shift);
+  size_t len = Stripped(norm_num, nn + 1);
+  if (dn < kNewtonThreshold || len - dn < kNewtonThreshold) {
+    norm_num[len] = 0;
+    DivKnuth(quot, norm_num, len + 1, norm_den, dn);
+    ShiftRightBits(rem, norm_num, dn, shift);
+    return;
+  }
+  size_t blocks = (len + dn - 1) / dn;
+  Limb* block_quot = frame.Allocate<Limb>(blocks * dn);
+  Limb* block_rem = frame.Allocate<Limb>(dn);
+  DivNewton(norm_num, len, norm_den, dn, block_quot, block_rem);
+  std::copy(block_quot, block_quot + std::min(blocks * dn, nn - dn + 2), quot);
+  ShiftRightBits(rem, block_rem, dn, shift);
+}
+// |num| >= |den| > 0
+static void DivModAbs(const LimbVector& num,
+                      const LimbVector& den, LimbVector& quot,
+                      LimbVector& rem) {
+  quot.resize(num.size() - den.size() + 2);
+  rem.resize(den.size());
+  DivModLimbs(num.data(), num.size(), den.data(), den.size(), quot.data(),
+              rem.data());
+  StripZeros(quot);
+  StripZeros(rem);
+}
+/* decimal conversion */
+using DecimalPowers = std::vector<const LimbVector*>;
+// 10^(19 * 2^k) for every k up to the first power longer than limbs, the
+// cache only grows, so the returned pointers stay valid
+static DecimalPowers GetDecimalPowers(size_t limbs) {
+  static std::mutex mutex;
+  static std::deque<LimbVector> powers;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (powers.empty()) {
+    powers.push_back({kDecimalBase});
+  }
+  while (powers.back().size() <= limbs) {
+    powers.push_back(MulAbs(powers.back(), powers.back()));
+  }
+  DecimalPowers result;
+  for (const LimbVector& power : powers) {
+    result.push_back(&power);
+  }
+  return result;
+}
+// upper bound of the digit count, log10(2) < 0.30103
+static size_t DecimalBound(const LimbVector& number) {
+  if (number.empty()) {
+    return 1;
+  }
+  size_t bits = (number.size() - 1) * kLimbBits + std::bit_width(number.back());
+  return bits * 30103 / 100000 + 2;
+}
+// exactly kDecimalDigits digits
+static void WriteChunk(Limb chunk, char* out) {
+  for (size_t i = kDecimalDigits; i > 0; --i) {
+    out[i - 1] = char('0' + chunk % kTen);
+    chunk /= kTen;
+  }
+}
+// value[0..n) < 10^(19 * 2^level) is written as exactly 19 * 2^level
+// digits, the value is consumed
+static void WritePadded(Limb* value, size_t n, size_t level,
+                        const DecimalPowers& powers, char* out) {
+  size_t width = kDecimalDigits << level;
+  n = Stripped(value, n);
+  if (n <= kRadixThreshold) {
+    for (size_t end = width; end > 0; end -= kDecimalDigits) {
+      WriteChunk(DivRemLimb(value, n, kDecimalBase),
+                 out + end - kDecimalDigits);
+      n = Stripped(value, n);
     }
+    return;
+  }
+  const LimbVector& power = *powers[level - 1];
+  if (CompareAbs(value, n, power.data(), power.size()) < 0) {
+    WritePadded(value, 0, level - 1, powers, out);
+    WritePadded(value, n, level - 1, powers, out + width / 2);
+    return;
+  }
+  ScratchArena::Frame frame;
+  Limb* quot = frame.Allocate<Limb>(n - power.size() + 2);
+  Limb* rem = frame.Allocate<Limb>(power.size());
+  DivModLimbs(value, n, power.data(), power.size(), quot, rem);
+  WritePadded(quot, n - power.size() + 2, level - 1, powers, out);
+  WritePadded(rem, power.size(), level - 1, powers, out + width / 2);
+}
+// non-zero value[0..n) without leading zeros, the value is consumed,
+// returns the end of the digits
+static char* WriteUnpadded(Limb* value, size_t n, const DecimalPowers& powers,
+                           char* out) {
+  if (n <= kRadixThreshold) {
+    // 19 digits take more than 63 bits, so there are at most n + 1 chunks
+    std::array<Limb, kRadixThreshold + 1> chunks;
+    size_t count = 0;
+    while (n != 0) {
+      chunks[count++] = DivRemLimb(value, n, kDecimalBase);
+      n = Stripped(value, n);
+    }
+    out = std::to_chars(out, out + kDecimalDigits, chunks[count - 1]).ptr;
+    for (size_t i = count - 1; i > 0; --i, out += kDecimalDigits) {
+      WriteChunk(chunks[i - 1], out);
+    }
+    return out;
+  }
+  size_t level = 0;
+  while (level + 1 < powers.size() &&
+         2 * powers[level + 1]->size() <= n + 1) {
+    ++level;
+  }
+  const LimbVector& power = *powers[level];
+  ScratchArena::Frame frame;
+  Limb* quot = frame.Allocate<Limb>(n - power.size() + 2);
+  Limb* rem = frame.Allocate<Limb>(power.size());
+  DivModLimbs(value, n, power.data(), power.size(), quot, rem);
+  out = WriteUnpadded(quot, Stripped(quot, n - power.size() + 2), powers, out);
+  WritePadded(rem, power.size(), level, powers, out);
+  return out + (kDecimalDigits << level);
+}
+static char* WriteDecimal(bool sign, const LimbVector& number,
+                          char* out) {
+  if (number.empty()) {
+    *out = '0';
+    return out + 1;
+  }
+  if (!sign) {
+    *out++ = '-';
   }
+  ScratchArena::Frame frame;
+  Limb* value = frame.Allocate<Limb>(number.size());
+  std::copy(number.begin(), number.end(), value);
+  return WriteUnpadded(value, number.size(), GetDecimalPowers(number.size()),
+                       out);
+}
+// limbs needed for the value of len digits, 10^19 < B
+static size_t DecimalLimbs(size_t len) { return len / kDecimalDigits + 2; }
+// the value of the digits goes to out, which has DecimalLimbs(len) limbs,
+// returns its length
+static size_t ParseChunks(const char* first, size_t len, Limb* out) {
+  size_t n = 0;
+  size_t head = len % kDecimalDigits;
+  if (head == 0) {
+    head = kDecimalDigits;
+  }
+  for (const char* last = first + len; first != last; head = kDecimalDigits) {
+    Limb chunk = 0;
+    Limb mult = 1;
+    for (size_t i = 0; i < head; ++i, ++first) {
+      chunk = chunk * kTen + Limb(*first - '0');
+      mult *= kTen;
+    }
+    n = MulAddLimb(out, n, mult, chunk);
+  }
+  return Stripped(out, n);
+}
+// same contract as ParseChunks, the lower 19 * 2^k digits are at least half
+// of the string
+static size_t ParseDigits(const char* first, size_t len,
+                          const DecimalPowers& powers, Limb* out) {
+  if (len <= kRadixThreshold * kDecimalDigits) {
+    return ParseChunks(first, len, out);
+  }
+  size_t level = 0;
+  while ((kDecimalDigits << (level + 1)) < len) {
+    ++level;
+  }
+  size_t low_len = kDecimalDigits << level;
+  size_t high_len = len - low_len;
+  const LimbVector& power = *powers[level];
+  ScratchArena::Frame frame;
+  Limb* high = frame.Allocate<Limb>(DecimalLimbs(high_len));
+  size_t hn = ParseDigits(first, high_len, powers, high);
+  Limb* low = frame.Allocate<Limb>(DecimalLimbs(low_len));
+  size_t ln = ParseDigits(first + high_len, low_len, powers, low);
+  size_t n = 0;
+  if (hn != 0) {
+    MulInto(out, high, hn, power.data(), power.size());
+    n = hn + power.size();
+  }
+  if (n < ln) {
+    std::fill(out + n, out + ln, 0);
+    n = ln;
+  }
+  if (Add(out, out, n, low, ln) != 0) {
+    out[n++] = 1;
+  }
+  return Stripped(out, n);
+}
+static LimbVector ParseDecimal(const char* first, size_t len) {
+  while (len > 0 && *first == '0') {
+    ++first;
+    --len;
+  }
+  LimbVector result(DecimalLimbs(len));
+  result.resize(ParseDigits(first, len,
+                            GetDecimalPowers(len / kDecimalDigits + 1),
+                            result.data()));
+  return result;
+}
+/* bitwise operations */
+// next limb of the two's complement form of a sign-magnitude number, the
+// borrow of |num| - 1 starts at one for negative numbers
+static Limb ComplementLimb(Limb limb, bool negative, Limb& borrow) {
+  if (!negative) {
+    return limb;
+  }
+  Limb diff = limb - borrow;
+  borrow = (limb < borrow) ? 1 : 0;
+  return ~diff;
+}
+// op on the two's complement forms in one pass, res gets the magnitude of
+// the result, returns true if it is negative
+template <typename Op>
+static bool BitwiseAbs(const LimbVector& lhs, bool lhs_negative,
+                       const LimbVector& rhs, bool rhs_negative, Op op,
+                       LimbVector& res) {
+  bool negative = op(Limb(lhs_negative), Limb(rhs_negative)) != 0;
+  size_t n = std::max(lhs.size(), rhs.size());
+  LimbVector result(n);
+  Limb lhs_borrow = 1;
+  Limb rhs_borrow = 1;
+  Limb carry = 1;
+  for (size_t i = 0; i < n; ++i) {
+    Limb limb = op(
+        ComplementLimb(i < lhs.size() ? lhs[i] : 0, lhs_negative, lhs_borrow),
+        ComplementLimb(i < rhs.size() ? rhs[i] : 0, rhs_negative, rhs_borrow));
+    if (negative) {
+      limb = ~limb + carry;
+      carry = (limb < carry) ? 1 : 0;
+    }
+    result[i] = limb;
+  }
+  if (negative && carry != 0) {
+    result.push_back(1);
+  }
+  StripZeros(result);
+  res = std::move(result);
+  return negative;
+}
+void BigInt::Normalize() {
+  StripZeros(number_);
+  if (number_.empty()) {
+    sign_ = true;
+  }
+}
+/* lazy sums */
+static const size_t kInlineTerms = 8;
+struct FusedTerm {
+  const Limb* data;
+  size_t size;
+  Limb scale;
+  bool subtract;
+};
+// adds the terms at limb i into cur and the high halves of their products
+// into high, terms shorter than i + 1 limbs are skipped if checked
+template <bool kChecked>
+static void AccumulateLimb(const FusedTerm* terms, size_t count, size_t i,
+                           SignedDoubleLimb& cur, SignedDoubleLimb& high) {
+  for (size_t j = 0; j < count; ++j) {
+    if (kChecked && i >= terms[j].size) {
+      continue;
+    }
+    DoubleLimb product = DoubleLimb(terms[j].data[i]) * terms[j].scale;
+    if (terms[j].subtract) {
+      cur -= Limb(product);
+      high -= Limb(product >> kLimbBits);
+    } else {
+      cur += Limb(product);
+      high += Limb(product >> kLimbBits);
+    }
+  }
+}
+// the signed sum is accumulated in two's complement with two spare limbs,
+// the high halves of the products join the carry into the next limb
+void BigInt::AssignTerms(const LinearTerm* terms, size_t count) {
+  FusedTerm inline_terms[kInlineTerms];
+  std::vector<FusedTerm> heap_terms;
+  FusedTerm* fused = inline_terms;
+  if (count > kInlineTerms) {
+    heap_terms.resize(count);
+    fused = heap_terms.data();
+  }
+  size_t len = 0;
+  size_t common = std::numeric_limits<size_t>::max();
+  for (size_t j = 0; j < count; ++j) {
+    const BigInt& value = *terms[j].value;
+    fused[j] = {value.number_.data(), value.number_.size(), terms[j].scale,
+                terms[j].negative == value.sign_};
+    len = std::max(len, fused[j].size);
+    common = std::min(common, fused[j].size);
+  }
+  LimbVector result(len + 2);
+  SignedDoubleLimb carry = 0;
+  for (size_t i = 0; i < result.size(); ++i) {
+    SignedDoubleLimb cur = carry;
+    SignedDoubleLimb high = 0;
+    if (i < common) {
+      AccumulateLimb<false>(fused, count, i, cur, high);
+    } else {
+      AccumulateLimb<true>(fused, count, i, cur, high);
+    }
+    result[i] = Limb(cur);
+    carry = (cur >> kLimbBits) + high;
+  }
+  sign_ = (result.back() & kTopBit) == 0;
+  if (!sign_) {
+    for (Limb& limb : result) {
+      limb = ~limb;
+    }
+    AddLimb(result.data(), result.data(), result.size(), 1);
+  }
+  number_ = std::move(result);
+  Normalize();
+}
+BigInt::BigInt(bool is_neg, const std::vector<Limb>& number)
+    : number_(number.data(), number.data() + number.size()), sign_(is_neg) {
+  Normalize();
+}
+BigInt::BigInt(bool is_neg, const LimbVector& number)
+    : number_(number), sign_(is_neg) {
+  Normalize();
+}
+BigInt::BigInt(bool is_neg, LimbVector&& number)
+    : number_(std::move(number)), sign_(is_neg) {
+  Normalize();
+}
+BigInt::BigInt(const std::vector<Limb>& number)
+    : number_(number.data(), number.data() + number.size()) {
+  Normalize();
+}
+BigInt::BigInt(int64_t number) : sign_(number >= 0) {
+  // unsigned negation also covers the minimal int64_t
+  Limb abs = sign_ ? Limb(number) : Limb(0) - Limb(number);
+  if (abs != 0) {
+    number_.push_back(abs);
+  }
+}
+BigInt::BigInt(bool sign, int64_t number) : sign_(sign) {
+  if (number != 0) {
+    number_.push_back(Limb(number));
+  }
+  Normalize();
 }
 BigInt::BigInt(const std::string& number) {
   if (number.empty()) {
@@ -55,32 +1193,18 @@ BigInt::BigInt(const std::string& number) {
     sign_ = false;
     ++index;
   }
-  size_t num_count = (number.length() - index) / kCountRank;
-  size_t num;
-  const int kTen = 10;
-  for (size_t i = 0; i < num_count; ++i) {
-    num = 0;
-    size_t j = 0;
-    size_t blocks = number.length() - (i + 1) * kCountRank + j;
-    while (j != kCountRank && blocks < number.length()) {
-      num = num * kTen + number[blocks] - '0';
-      ++j;
-      blocks = number.length() - (i + 1) * kCountRank + j;
-    }
-    number_.push_back(num);
-  }
-  num = 0;
-  for (size_t i = index; i < number.length() - num_count * kCountRank; ++i) {
-    num = num * kTen + number[i] - '0';
-  }
-  if (num != 0 || number_.empty()) {
-    number_.push_back(num);
-  }
+  number_ = ParseDecimal(number.data() + index, number.length() - index);
+  Normalize();
 }
 BigInt::BigInt(const BigInt& bi) {
   sign_ = bi.sign_;
   number_ = bi.number_;
 }
+BigInt::BigInt(BigInt&& bi) noexcept
+    : number_(std::move(bi.number_)), sign_(bi.sign_) {
+  bi.number_.clear();
+  bi.sign_ = true;
+}
 BigInt& BigInt::operator=(const BigInt& num) {
   if (this == &num) {
     return *this;
@@ -89,245 +1213,183 @@ BigInt& BigInt::operator=(const BigInt& num) {
   number_ = num.number_;
   return *this;
 }
-BigInt BigInt::operator++() {
-  BigInt tmp = *this;
-  *this = *this + BigInt(1);
+BigInt& BigInt::operator=(BigInt&& num) noexcept {
+  if (this == &num) {
+    return *this;
+  }
+  sign_ = num.sign_;
+  number_ = std::move(num.number_);
+  num.number_.clear();
+  num.sign_ = true;
   return *this;
 }
-BigInt BigInt::operator--() {
-  BigInt tmp = *this;
-  *this = *this - BigInt(1);
+void BigInt::IncrementAbs() {
+  if (AddLimb(number_.data(), number_.data(), number_.size(), 1) != 0) {
+    number_.push_back(1);
+  }
+}
+void BigInt::DecrementAbs() {
+  SubLimb(number_.data(), number_.data(), number_.size(), 1);
+  Normalize();
+}
+BigInt& BigInt::operator++() {
+  if (sign_) {
+    IncrementAbs();
+  } else {
+    DecrementAbs();
+  }
+  return *this;
+}
+BigInt& BigInt::operator--() {
+  if (sign_ && !number_.empty()) {
+    DecrementAbs();
+  } else {
+    sign_ = false;
+    IncrementAbs();
+  }
   return *this;
 }
 BigInt BigInt::operator++(int) {
   BigInt tmp = *this;
-  *this = *this + BigInt(1);
+  ++*this;
   return tmp;
 }
 BigInt BigInt::operator--(int) {
   BigInt tmp = *this;
-  *this = *this - BigInt(1);
+  --*this;
   return tmp;
 }
 bool BigInt::operator==(const BigInt& num) const {
-  if (this->number_.size() != num.number_.size()) {
-    return false;
-  }
-  if (this->sign_ != num.sign_) {
-    if (this->number_.size() == 1 && num.number_.size() == 1) {
-      if (this->number_[0] == 0 && num.number_[0] == 0) {
-        return true;
-      }
-    }
-    return false;
-  }
-  for (size_t i = 0; i < num.number_.size(); ++i) {
-    if (this->number_[i] != num.number_[i]) {
-      return false;
-    }
-  }
-  return true;
+  return sign_ == num.sign_ && number_ == num.number_;
 }
 bool BigInt::operator!=(const BigInt& num) const { return !(*this == num); }
 bool BigInt::operator<(const BigInt& num) const {
-  if (!sign_ && !num.sign_) {
-    return -*this > -num;
-  }
-  if (!sign_ && num.sign_) {
-    return true;
-  }
-  if (sign_ && !num.sign_) {
-    return false;
-  }
-
-  if (number_.size() != num.number_.size()) {
-    return number_.size() < num.number_.size();
-  }
-  for (int i = number_.size() - 1; i >= 0; --i) {
-    if (number_[i] > num.number_[i]) {
-      return !this->sign_;
-    }
-    if (number_[i] < num.number_[i]) {
-      return this->sign_;
-    }
+  if (sign_ != num.sign_) {
+    return !sign_;
   }
-  return false;
+  int cmp = CompareAbs(number_, num.number_);
+  return sign_ ? cmp < 0 : cmp > 0;
 }
 bool BigInt::operator>(const BigInt& num) const { return num < *this; }
 BigInt BigInt::operator-() const { return BigInt(!sign_, number_); }
-std::ostream& operator<<(std::ostream& os, const BigInt& out) {
-  if (!out.sign_) {
-    os << "-";
-  }
-  const int kTen = 10;
-  os << out.number_.back();
-  for (int i = out.number_.size() - 2; i >= 0; --i) {
-    int zeros = 0;
-    int number = out.number_[i];
-    for (size_t j = 0; j < out.kCountRank; ++j) {
-      number /= kTen;
-      if (number == 0) {
-        zeros = out.kCountRank - j - 1;
-        break;
-      }
-    }
-    for (; zeros > 0; --zeros) {
-      os << "0";
-    }
-    os << out.number_[i];
-  }
-  return os;
+std::string BigInt::ToString() const {
+  std::string result(DecimalBound(number_) + 1, '0');
+  char* end = WriteDecimal(sign_, number_, result.data());
+  result.resize(end - result.data());
+  return result;
 }
-BigInt& BigInt::operator+=(const BigInt& num) {
-  BigInt tmp = Plus(num);
-  *this = tmp;
-  return *this;
+std::to_chars_result ToChars(char* first, char* last, const BigInt& num) {
+  size_t bound = DecimalBound(num.number_) + 1;
+  if (size_t(last - first) >= bound) {
+    return {WriteDecimal(num.sign_, num.number_, first), std::errc()};
+  }
+  std::string digits = num.ToString();
+  if (size_t(last - first) < digits.size()) {
+    return {last, std::errc::value_too_large};
+  }
+  return {std::copy(digits.begin(), digits.end(), first), std::errc()};
 }
-static BigInt MinusResult(bool sign, std::vector<size_t> result) {
-  if (result.empty()) {
-    return BigInt(0);
+std::from_chars_result FromChars(const char* first, const char* last,
+                                 BigInt& num) {
+  const char* cur = first;
+  bool sign = true;
+  if (cur != last && *cur == '-') {
+    sign = false;
+    ++cur;
   }
-  while (result.size() > 1 && result[result.size() - 1] == 0) {
-    result.resize(result.size() - 1);
+  const char* digits = cur;
+  while (cur != last && *cur >= '0' && *cur <= '9') {
+    ++cur;
   }
-  return BigInt(sign, result);
+  if (cur == digits) {
+    return {first, std::errc::invalid_argument};
+  }
+  num = BigInt(sign, ParseDecimal(digits, cur - digits));
+  return {cur, std::errc()};
 }
-
-BigInt BigInt::Minus(const BigInt& num) {
-  if (!sign_ && !num.sign_) {
-    return -((-*this) - (-num));
+std::ostream& operator<<(std::ostream& os, const BigInt& out) {
+  return os << out.ToString();
+}
+BigInt BigInt::AddWithSign(const BigInt& num, bool num_sign) const {
+  if (sign_ == num_sign) {
+    return BigInt(sign_, AddAbs(number_, num.number_));
   }
-  if (!num.sign_) {
-    return *this + (-num);
+  if (CompareAbs(number_, num.number_) >= 0) {
+    return BigInt(sign_, SubAbs(number_, num.number_));
   }
-  if (!sign_) {
-    return -(-*this + num);
-  }
-  bool result_sign = (*this >= num);
-  BigInt a = *this < num ? num : *this;
-  BigInt b = *this < num ? *this : num;
-  std::vector<size_t> result;
-  int64_t tmp = 0;
-  for (size_t i = 0; i < a.number_.size(); ++i) {
-    if (i < b.number_.size()) {
-      tmp += a.number_[i] - b.number_[i];
-    } else {
-      tmp += a.number_[i];
+  return BigInt(num_sign, SubAbs(num.number_, number_));
+}
+void BigInt::AddInPlace(const BigInt& num, bool num_sign) {
+  size_t ln = number_.size();
+  size_t rn = num.number_.size();
+  if (sign_ == num_sign) {
+    if (ln < rn) {
+      number_.resize(rn);
     }
-    if (tmp < 0) {
-      result.push_back(num.kRank + tmp);
-      tmp = -1;
-    } else {
-      result.push_back(tmp % num.kRank);
-      tmp /= kRank;
+    Limb carry = Add(number_.data(), number_.data(), number_.size(),
+                     num.number_.data(), rn);
+    if (carry != 0) {
+      number_.push_back(carry);
     }
+    return;
   }
-  return MinusResult(result_sign, result);
+  if (CompareAbs(number_, num.number_) >= 0) {
+    Sub(number_.data(), number_.data(), ln, num.number_.data(), rn);
+  } else {
+    number_.resize(rn);
+    Sub(number_.data(), num.number_.data(), rn, number_.data(), ln);
+    sign_ = num_sign;
+  }
+  Normalize();
+}
+BigInt& BigInt::operator+=(const BigInt& num) {
+  AddInPlace(num, num.sign_);
+  return *this;
 }
+BigInt BigInt::Minus(const BigInt& num) { return AddWithSign(num, !num.sign_); }
 
 BigInt& BigInt::operator-=(const BigInt& num) {
-  BigInt tmp = Minus(num);
-  *this = tmp;
+  AddInPlace(num, !num.sign_);
   return *this;
 }
-BigInt BigInt::operator-(const BigInt& num) const {
-  BigInt tmp = *this;
-  return tmp -= num;
+BigInt BigInt::operator-(const BigInt& num) const& {
+  return AddWithSign(num, !num.sign_);
+}
+BigInt BigInt::operator-(const BigInt& num) && {
+  AddInPlace(num, !num.sign_);
+  return std::move(*this);
 }
 void BigInt::ShiftLeft(size_t n) {
-  if (*this == BigInt("0") || n == 0) {
+  if (number_.empty() || n == 0) {
     return;
   }
-  std::vector<size_t> tmp = number_;
-  size_t i = 0;
-  while (i < n) {
-    number_.push_back(0);
-    ++i;
-  }
-  for (i = 0; i < number_.size() - n; ++i) {
-    number_[number_.size() - 1 - i] = number_[number_.size() - n - 1 - i];
-  }
-  for (i = 0; i < n; ++i) {
-    number_[i] = 0;
-  }
+  number_.insert(number_.begin(), n, 0);
 }
 void BigInt::ShiftRight(size_t n) {
   if (n == 0) {
     return;
   }
-  for (size_t i = 0; i < number_.size() - n; ++i) {
-    number_[i] = number_[i + n];
-  }
-  number_.resize(number_.size() - n);
-}
-static BigInt Karatsuba(BigInt x, BigInt y, size_t x_shift, size_t y_shift,
-                        size_t fixed) {
-  x.ShiftLeft(x_shift);
-  y.ShiftLeft(y_shift);
-  BigInt a = x.Slice(0, fixed / 2);
-  BigInt b = x.Slice(fixed / 2, fixed);
-  BigInt c = y.Slice(0, fixed / 2);
-  BigInt d = y.Slice(fixed / 2, fixed);
-  BigInt first = a * c;
-  BigInt second = b * d;
-  BigInt third = (a + b) * (c + d);
-  BigInt tmp = third - second - first;
-  first.ShiftLeft(fixed);
-  tmp.ShiftLeft(fixed / 2);
-  return first + tmp + second;
-}
-BigInt BigInt::ResultMult(const BigInt& num, BigInt res,
-                          size_t xy_shift) const {
-  if (sign_ != num.sign_) {
-    res = -res;
-  }
-  if (res != BigInt("0")) {
-    res.ShiftRight(xy_shift);
+  if (n >= number_.size()) {
+    number_.clear();
+    Normalize();
+    return;
   }
-  return res;
+  number_.erase(number_.begin(), number_.begin() + n);
 }
 BigInt BigInt::Mult(const BigInt& num) {
-  BigInt x = *this >= 0 ? *this : -*this;
-  BigInt y = num >= 0 ? num : -num;
-  if (x == BigInt("0") || y == BigInt("0")) {
-    return BigInt("0");
-  }
-  size_t n =
-      x.number_.size() > y.number_.size() ? x.number_.size() : y.number_.size();
-  if (n == 1) {
-    return BigInt(sign_ == num.sign_, x.ToInt() * y.ToInt());
-  }
-  size_t x_shift = 0;
-  size_t y_shift = 0;
-  size_t xy_shift;
-  if (x <= y) {
-    x_shift = y.number_.size() - x.number_.size();
-    xy_shift = x_shift;
-  } else {
-    y_shift = x.number_.size() - y.number_.size();
-    xy_shift = y_shift;
-  }
-  size_t fixed = n;
-  if ((x.number_.size() + x_shift) % 2 != 0) {
-    xy_shift += 2;
-    ++fixed;
-    ++x_shift;
-    ++y_shift;
-  }
-  BigInt res = Karatsuba(x, y, x_shift, y_shift, fixed);
-  return ResultMult(num, res, xy_shift);
+  return BigInt(sign_ == num.sign_, MulAbs(number_, num.number_));
 }
 BigInt& BigInt::operator*=(const BigInt& num) {
-  BigInt tmp = Mult(num);
-  *this = tmp;
+  number_ = MulAbs(number_, num.number_);
+  sign_ = (sign_ == num.sign_);
+  Normalize();
   return *this;
 }
 BigInt BigInt::operator*(const BigInt& num) const {
-  BigInt tmp = *this;
-  return tmp *= num;
+  return BigInt(sign_ == num.sign_, MulAbs(number_, num.number_));
 }
 BigInt BigInt::Slice(size_t left, size_t right) const {
-  std::vector<size_t> result;
+  LimbVector result;
   size_t i = left;
   while (i < right && i < number_.size()) {
     result.push_back(number_[number_.size() - 1 - i]);
@@ -336,151 +1398,334 @@ BigInt BigInt::Slice(size_t left, size_t right) const {
   for (i = 0; i < result.size() / 2; ++i) {
     std::swap(result[i], result[result.size() - 1 - i]);
   }
-  while (result.size() > 1 && result[result.size() - 1] == 0) {
-    result.pop_back();
+  return BigInt(true, std::move(result));
+}
+BigInt BigInt::Div(size_t num) const {
+  LimbVector result = number_;
+  DivRemLimb(result, num);
+  return BigInt(true, std::move(result));
+}
+std::pair<BigInt, BigInt> BigInt::DivMod(const BigInt& num) const {
+  if (num.number_.empty() || CompareAbs(number_, num.number_) < 0) {
+    return {BigInt(), *this};
   }
-  if (result.empty()) {
-    return BigInt("0");
+  LimbVector quot;
+  LimbVector rem;
+  DivModAbs(number_, num.number_, quot, rem);
+  return {BigInt(sign_ == num.sign_, std::move(quot)),
+          BigInt(sign_, std::move(rem))};
+}
+BigInt BigInt::operator%(const BigInt& num) const { return DivMod(num).second; }
+BigInt BigInt::Division(const BigInt& num) { return DivMod(num).first; }
+BigInt& BigInt::operator/=(const BigInt& num) {
+  *this = DivMod(num).first;
+  return *this;
+}
+BigInt BigInt::operator/(const BigInt& num) const { return DivMod(num).first; }
+bool BigInt::operator<=(const BigInt& num) const { return !(*this > num); }
+bool BigInt::operator>=(const BigInt& num) const { return !(*this < num); }
+size_t BigInt::ToInt() const {
+  size_t result = number_.empty() ? 0 : number_[0];
+  if (sign_) {
+    return result;
   }
-  return BigInt(true, result);
+  return -result;
+}
+BigInt BigInt::Plus(const BigInt& num) { return AddWithSign(num, num.sign_); }
+BigInt BigInt::operator+(const BigInt& num) const& {
+  return AddWithSign(num, num.sign_);
+}
+BigInt BigInt::operator+(const BigInt& num) && {
+  AddInPlace(num, num.sign_);
+  return std::move(*this);
+}
+BigInt BigInt::operator&(const BigInt& num) const {
+  BigInt result = *this;
+  result &= num;
+  return result;
+}
+BigInt BigInt::operator|(const BigInt& num) const {
+  BigInt result = *this;
+  result |= num;
+  return result;
+}
+BigInt BigInt::operator^(const BigInt& num) const {
+  BigInt result = *this;
+  result ^= num;
+  return result;
+}
+BigInt BigInt::operator~() const {
+  BigInt result = *this;
+  ++result;
+  result.sign_ = !result.sign_;
+  result.Normalize();
+  return result;
+}
+BigInt& BigInt::operator&=(const BigInt& num) {
+  sign_ = !BitwiseAbs(number_, !sign_, num.number_, !num.sign_,
+                      [](Limb lhs, Limb rhs) { return lhs & rhs; }, number_);
+  Normalize();
+  return *this;
 }
-static std::string SplitDec(int n) {
-  if (n <= 0) {
-    return "0";
+BigInt& BigInt::operator|=(const BigInt& num) {
+  sign_ = !BitwiseAbs(number_, !sign_, num.number_, !num.sign_,
+                      [](Limb lhs, Limb rhs) { return lhs | rhs; }, number_);
+  Normalize();
+  return *this;
+}
+BigInt& BigInt::operator^=(const BigInt& num) {
+  sign_ = !BitwiseAbs(number_, !sign_, num.number_, !num.sign_,
+                      [](Limb lhs, Limb rhs) { return lhs ^ rhs; }, number_);
+  Normalize();
+  return *this;
+}
+BigInt BigInt::operator<<(size_t bits) const {
+  BigInt result = *this;
+  result <<= bits;
+  return result;
+}
+// only the limbs that survive are copied
+BigInt BigInt::operator>>(size_t bits) const {
+  size_t limbs = bits / kLimbBits;
+  if (!sign_ || limbs >= number_.size()) {
+    BigInt result = *this;
+    result >>= bits;
+    return result;
   }
-  std::string result = "1";
-  int count = 0;
-  while (count < n) {
-    result += "000000000";
-    ++count;
+  LimbVector result(number_.size() - limbs);
+  ShiftRightBits(result.data(), number_.data() + limbs, result.size(),
+                 bits % kLimbBits);
+  StripZeros(result);
+  return BigInt(true, std::move(result));
+}
+BigInt& BigInt::operator<<=(size_t bits) {
+  if (number_.empty()) {
+    return *this;
   }
-  return result;
+  size_t limbs = bits / kLimbBits;
+  size_t n = number_.size();
+  LimbVector result(n + limbs + 1);
+  result[n + limbs] =
+      ShiftLeftBits(result.data() + limbs, number_.data(), n, bits % kLimbBits);
+  StripZeros(result);
+  number_ = std::move(result);
+  return *this;
 }
-BigInt BigInt::Div(size_t num) const {
-  std::vector<size_t> result(number_.size(), 0);
-  size_t tmp = 0;
-  size_t index = 0;
-  size_t current = 0;
-  for (size_t i = 0; i < number_.size(); ++i) {
-    index = number_.size() - 1 - i;
-    current = tmp * kRank + number_[index];
-    tmp = current % num;
-    result[index] = current / num;
-  }
-  while (result.size() > 1 && result[result.size() - 1] == 0) {
-    result.pop_back();
-  }
-  return BigInt(true, result);
-}
-BigInt BigInt::operator%(const BigInt& num) const {
-  return *this - (*this / num) * num;
-}
-BigInt BigInt::DivResult(int range, const BigInt& num) const {
-  BigInt left(SplitDec(range - 1));
-  BigInt right(SplitDec(range + 1));
-  BigInt tmp;
-  BigInt result;
-  BigInt diff = *this - num;
-  while (right - left > 1) {
-    tmp = left + right;
-    tmp = tmp.Div(2);
-    result = tmp * num;
-    if (result <= *this && result > diff) {
-      return tmp;
-    }
-    if (result > *this) {
-      right = tmp;
-    } else {
-      left = tmp;
+// a negative number loses one more unit when any set bit is shifted out
+BigInt& BigInt::operator>>=(size_t bits) {
+  size_t limbs = bits / kLimbBits;
+  size_t shift = bits % kLimbBits;
+  if (limbs >= number_.size()) {
+    bool negative = !sign_ && !number_.empty();
+    number_.clear();
+    sign_ = !negative;
+    if (negative) {
+      number_.push_back(1);
     }
+    return *this;
+  }
+  bool inexact =
+      !sign_ && (!std::all_of(number_.begin(), number_.begin() + limbs,
+                              [](Limb limb) { return limb == 0; }) ||
+                 (shift != 0 && (number_[limbs] << (kLimbBits - shift)) != 0));
+  size_t n = number_.size() - limbs;
+  ShiftRightBits(number_.data(), number_.data() + limbs, n, shift);
+  number_.resize(n);
+  StripZeros(number_);
+  if (inexact) {
+    IncrementAbs();
+  }
+  Normalize();
+  return *this;
+}
+size_t BigInt::PopCount() const {
+  size_t count = 0;
+  for (Limb limb : number_) {
+    count += std::popcount(limb);
   }
-  if (right * num > diff && right * num <= *this) {
-    return right;
+  return count;
+}
+size_t BigInt::BitLength() const {
+  if (number_.empty()) {
+    return 0;
   }
-  if (left * num > diff && left * num <= *this) {
-    return left;
+  return number_.size() * kLimbBits - std::countl_zero(number_.back());
+}
+// a negative number is stored as ~(|num| - 1), the borrow of the
+// decrement reaches a bit exactly when all lower bits of |num| are zero
+bool BigInt::TestBit(size_t bit) const {
+  size_t index = bit / kLimbBits;
+  Limb mask = Limb(1) << (bit % kLimbBits);
+  bool set = index < number_.size() && (number_[index] & mask) != 0;
+  if (sign_) {
+    return set;
   }
-  return tmp;
+  bool lower_zero =
+      index < number_.size() &&
+      std::all_of(number_.begin(), number_.begin() + index,
+                  [](Limb limb) { return limb == 0; }) &&
+      (number_[index] & (mask - 1)) == 0;
+  return set == lower_zero;
 }
-BigInt BigInt::Division(const BigInt& num) {
-  if (num == BigInt("0")) {
-    return BigInt("0");
+std::istream& operator>>(std::istream& in, BigInt& num) {
+  std::string str;
+  in >> str;
+  num = BigInt(str);
+  return in;
+}
+/* binary form and views */
+static const size_t kHeaderBytes = sizeof(Limb);
+static void StoreLimbs(uint8_t* out, const Limb* limbs, size_t n) {
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(out, limbs, n * sizeof(Limb));
+    return;
   }
-  if (!sign_ && !num.sign_) {
-    return (-*this) / (-num);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t byte = 0; byte < sizeof(Limb); ++byte) {
+      *out++ = uint8_t(limbs[i] >> (8 * byte));
+    }
   }
-  if (!sign_ && num.sign_) {
-    return -(-*this / num);
+}
+static void LoadLimbs(Limb* limbs, const uint8_t* in, size_t n) {
+  if constexpr (std::endian::native == std::endian::little) {
+    std::memcpy(limbs, in, n * sizeof(Limb));
+    return;
   }
-  if (sign_ && !num.sign_) {
-    return -(*this / (-num));
+  for (size_t i = 0; i < n; ++i) {
+    limbs[i] = 0;
+    for (size_t byte = 0; byte < sizeof(Limb); ++byte) {
+      limbs[i] |= Limb(*in++) << (8 * byte);
+    }
   }
-  if (*this < num) {
-    return BigInt("0");
+}
+// limb count and sign of the number at the front of [first, last), false
+// when it does not fit or is not normalized
+static bool ReadHeader(const uint8_t* first, const uint8_t* last, size_t& size,
+                       bool& negative) {
+  if (size_t(last - first) < kHeaderBytes) {
+    return false;
   }
-  if (num == BigInt("1")) {
-    return *this;
+  Limb header;
+  LoadLimbs(&header, first, 1);
+  size = header >> 1;
+  negative = (header & 1) != 0;
+  if ((size_t(last - first) - kHeaderBytes) / sizeof(Limb) < size) {
+    return false;
+  }
+  if (size == 0) {
+    return !negative;
   }
-  int range = number_.size() - num.number_.size();
-  return DivResult(range, num);
+  Limb top;
+  LoadLimbs(&top, first + kHeaderBytes + (size - 1) * sizeof(Limb), 1);
+  return top != 0;
 }
-BigInt& BigInt::operator/=(const BigInt& num) {
-  BigInt tmp = Division(num);
-  *this = tmp;
-  return *this;
+size_t BigInt::SerializedSize() const {
+  return kHeaderBytes + number_.size() * sizeof(Limb);
 }
-BigInt BigInt::operator/(const BigInt& num) const {
-  BigInt tmp = *this;
-  return tmp /= num;
+uint8_t* BigInt::Serialize(uint8_t* out) const {
+  Limb header = (Limb(number_.size()) << 1) | (sign_ ? 0 : 1);
+  StoreLimbs(out, &header, 1);
+  StoreLimbs(out + kHeaderBytes, number_.data(), number_.size());
+  return out + SerializedSize();
 }
-bool BigInt::operator<=(const BigInt& num) const { return !(*this > num); }
-bool BigInt::operator>=(const BigInt& num) const { return !(*this < num); }
-size_t BigInt::ToInt() const {
-  size_t result = 0;
-  size_t i = 0;
-  while (i < number_.size()) {
-    result = result * kCountRank + number_[number_.size() - 1 - i];
-    ++i;
+std::vector<uint8_t> BigInt::Serialize() const {
+  std::vector<uint8_t> result(SerializedSize());
+  Serialize(result.data());
+  return result;
+}
+const uint8_t* Deserialize(const uint8_t* first, const uint8_t* last,
+                           BigInt& num) {
+  size_t size;
+  bool negative;
+  if (!ReadHeader(first, last, size, negative)) {
+    return nullptr;
   }
-  if (sign_) {
-    return result;
+  num.number_.clear();
+  num.number_.resize(size);
+  LoadLimbs(num.number_.data(), first + kHeaderBytes, size);
+  num.sign_ = !negative;
+  return first + kHeaderBytes + size * sizeof(Limb);
+}
+const uint8_t* DeserializeView(const uint8_t* first, const uint8_t* last,
+                               BigIntView& view) {
+  size_t size;
+  bool negative;
+  if (std::endian::native != std::endian::little ||
+      reinterpret_cast<uintptr_t>(first) % alignof(Limb) != 0 ||
+      !ReadHeader(first, last, size, negative)) {
+    return nullptr;
   }
-  return -result;
+  view = BigIntView(reinterpret_cast<const Limb*>(first + kHeaderBytes), size,
+                    negative);
+  return first + kHeaderBytes + size * sizeof(Limb);
 }
-BigInt BigInt::Plus(const BigInt& num) {
-  if (!sign_ && num.sign_) {
-    return num - (-*this);
+
+BigIntView::BigIntView(const Limb* limbs, size_t size, bool negative)
+    : limbs_(limbs), size_(Stripped(limbs, size)) {
+  negative_ = negative && size_ != 0;
+}
+BigIntView::BigIntView(const BigInt& num)
+    : limbs_(num.number_.data()),
+      size_(num.number_.size()),
+      negative_(!num.sign_) {}
+BigInt BigIntView::ToBigInt() const {
+  return BigInt(!negative_, LimbVector(limbs_, limbs_ + size_));
+}
+BigIntView BigIntView::operator-() const {
+  BigIntView result = *this;
+  result.negative_ = !negative_ && size_ != 0;
+  return result;
+}
+int Compare(BigIntView lhs, BigIntView rhs) {
+  if (lhs.negative_ != rhs.negative_) {
+    return lhs.negative_ ? -1 : 1;
   }
-  if (sign_ && !num.sign_) {
-    return *this - (-num);
+  int cmp = CompareAbs(lhs.limbs_, lhs.size_, rhs.limbs_, rhs.size_);
+  return lhs.negative_ ? -cmp : cmp;
+}
+// the limbs of dest are written in place unless an operand reads them, a
+// new buffer then replaces them once the result is complete
+static bool Reads(const LimbVector& dest, BigIntView view) {
+  std::less_equal<const Limb*> less_equal;
+  return view.Size() != 0 && less_equal(dest.data(), view.Data()) &&
+         less_equal(view.Data(), dest.data() + dest.capacity());
+}
+void Add(BigInt& dest, BigIntView lhs, BigIntView rhs) {
+  if (lhs.size_ < rhs.size_) {
+    std::swap(lhs, rhs);
   }
-  size_t tmp = 0;
-  std::vector<size_t> new_num;
-  size_t n =
-      number_.size() > num.number_.size() ? number_.size() : num.number_.size();
-  for (size_t i = 0; i < n; ++i) {
-    if (i < number_.size()) {
-      tmp += number_[i];
-    }
-    if (i < num.number_.size()) {
-      tmp += num.number_[i];
+  LimbVector fresh;
+  bool aliased = Reads(dest.number_, lhs) || Reads(dest.number_, rhs);
+  LimbVector& result = aliased ? fresh : dest.number_;
+  bool negative = lhs.negative_;
+  result.clear();
+  if (lhs.negative_ == rhs.negative_) {
+    result.resize(lhs.size_ + 1);
+    result[lhs.size_] =
+        Add(result.data(), lhs.limbs_, lhs.size_, rhs.limbs_, rhs.size_);
+  } else {
+    result.resize(lhs.size_);
+    if (AbsDiff(result.data(), lhs.limbs_, lhs.size_, rhs.limbs_, rhs.size_)) {
+      negative = rhs.negative_;
     }
-    new_num.push_back(tmp % kRank);
-    tmp -= tmp % kRank;
-    tmp /= kRank;
   }
-  if (tmp != 0) {
-    new_num.push_back(tmp);
+  if (aliased) {
+    dest.number_ = std::move(fresh);
   }
-  return BigInt(sign_, new_num);
-}
-BigInt BigInt::operator+(const BigInt& num) const {
-  BigInt tmp = *this;
-  return tmp += num;
+  dest.sign_ = !negative;
+  dest.Normalize();
 }
-std::istream& operator>>(std::istream& in, BigInt& num) {
-  std::string str;
-  in >> str;
-  num = BigInt(str);
-  return in;
+void Sub(BigInt& dest, BigIntView lhs, BigIntView rhs) { Add(dest, lhs, -rhs); }
+void Mul(BigInt& dest, BigIntView lhs, BigIntView rhs) {
+  LimbVector fresh;
+  bool aliased = Reads(dest.number_, lhs) || Reads(dest.number_, rhs);
+  LimbVector& result = aliased ? fresh : dest.number_;
+  result.clear();
+  result.resize(lhs.size_ + rhs.size_);
+  MulInto(result.data(), lhs.limbs_, lhs.size_, rhs.limbs_, rhs.size_);
+  if (aliased) {
+    dest.number_ = std::move(fresh);
+  }
+  dest.sign_ = lhs.negative_ == rhs.negative_;
+  dest.Normalize();
 }
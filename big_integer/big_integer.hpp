@@ -1,58 +1,305 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <system_error>
 #include <type_traits>
+#include <utility>
 #include <vector>
+
+#include "limb_vector.hpp"
+template <size_t N>
+class BigIntExpr;
+class BigIntView;
 class BigInt {
  public:
+  using Limb = uint64_t;
+  // sizes of the smaller operand in limbs from which multiplication switches
+  // to Karatsuba, Toom-3 and the number theoretic transform
+  struct MulThresholds {
+    size_t karatsuba;
+    size_t toom3;
+    size_t ntt;
+  };
+  static MulThresholds mul_thresholds;
+  // products whose smaller operand has at least min_limbs limbs run their
+  // Karatsuba and Toom-3 branches and their transforms on up to max_threads
+  // threads, zero means one per hardware thread
+  struct ThreadOptions {
+    size_t max_threads;
+    size_t min_limbs;
+  };
+  static ThreadOptions thread_options;
+  // scale * value, negated when negative, one summand of a BigIntExpr
+  struct LinearTerm {
+    const BigInt* value;
+    Limb scale;
+    bool negative;
+  };
   BigInt() = default;
-  BigInt(bool is_neg, const std::vector<size_t>& number);
-  BigInt(const std::vector<size_t>& number);
+  BigInt(bool is_neg, const std::vector<Limb>& number);
+  BigInt(bool is_neg, const LimbVector& number);
+  BigInt(bool is_neg, LimbVector&& number);
+  BigInt(const std::vector<Limb>& number);
   BigInt(int64_t number);
   BigInt(const std::string& number);
   BigInt(const BigInt& bi);
+  BigInt(BigInt&& bi) noexcept;
   BigInt(bool sign, int64_t number);
+  // evaluates a lazy sum in one pass over the limbs
+  template <size_t N>
+  BigInt(const BigIntExpr<N>& expr);
   void ShiftLeft(size_t n);
   void ShiftRight(size_t n);
   BigInt Slice(size_t l, size_t r) const;
   BigInt& operator=(const BigInt& num);
+  BigInt& operator=(BigInt&& num) noexcept;
+  template <size_t N>
+  BigInt& operator=(const BigIntExpr<N>& expr);
   BigInt Div(size_t num) const;
   bool operator==(const BigInt& num) const;
   BigInt operator%(const BigInt& num) const;
   bool operator!=(const BigInt& num) const;
   bool operator<(const BigInt& num) const;
   bool operator>(const BigInt& num) const;
-  BigInt operator+(const BigInt& num) const;
+  BigInt operator+(const BigInt& num) const&;
+  // a temporary left operand is reused as the result
+  BigInt operator+(const BigInt& num) &&;
   BigInt operator*(const BigInt& num) const;
   BigInt operator/(const BigInt& num) const;
   BigInt& operator-=(const BigInt& num);
   BigInt& operator+=(const BigInt& num);
   BigInt Minus(const BigInt& num);
   BigInt Plus(const BigInt& num);
-  BigInt operator-(const BigInt& num) const;
+  BigInt operator-(const BigInt& num) const&;
+  BigInt operator-(const BigInt& num) &&;
   BigInt operator-() const;
-  BigInt ResultMult(const BigInt& num, BigInt res, size_t xy_shift) const;
   BigInt Mult(const BigInt& num);
   BigInt Division(const BigInt& num);
   BigInt& operator*=(const BigInt& num);
   BigInt& operator/=(const BigInt& num);
-  BigInt DivResult(int range, const BigInt& num) const;
+  // quotient rounded towards zero and the remainder with the sign of *this
+  std::pair<BigInt, BigInt> DivMod(const BigInt& num) const;
   bool operator<=(const BigInt& num) const;
   bool operator>=(const BigInt& num) const;
-  BigInt operator++();
-  BigInt operator--();
+  BigInt& operator++();
+  BigInt& operator--();
   BigInt operator++(int);
   BigInt operator--(int);
+  // bitwise operators act on the infinite two's complement form, so -1 has
+  // every bit set and ~x is -x - 1
+  BigInt operator&(const BigInt& num) const;
+  BigInt operator|(const BigInt& num) const;
+  BigInt operator^(const BigInt& num) const;
+  BigInt operator~() const;
+  BigInt& operator&=(const BigInt& num);
+  BigInt& operator|=(const BigInt& num);
+  BigInt& operator^=(const BigInt& num);
+  // shifts by bits, >> rounds towards minus infinity as on two's complement
+  BigInt operator<<(size_t bits) const;
+  BigInt operator>>(size_t bits) const;
+  BigInt& operator<<=(size_t bits);
+  BigInt& operator>>=(size_t bits);
+  // set and significant bits of the magnitude
+  size_t PopCount() const;
+  size_t BitLength() const;
+  // bit of the two's complement form
+  bool TestBit(size_t bit) const;
   size_t ToInt() const;
+  std::string ToString() const;
+  // decimal conversion without iostreams, same contract as std::to_chars and
+  // std::from_chars with an optional leading minus
+  friend std::to_chars_result ToChars(char* first, char* last,
+                                      const BigInt& num);
+  friend std::from_chars_result FromChars(const char* first, const char* last,
+                                          BigInt& num);
   friend std::ostream& operator<<(std::ostream& os, const BigInt& out);
   friend std::istream& operator>>(std::istream& in, BigInt& num);
+  // little-endian binary form: a 64-bit header holding the limb count
+  // shifted left by one with the low bit set for negative numbers, then the
+  // limbs, so limbs of a buffer that starts 8-byte aligned stay aligned
+  size_t SerializedSize() const;
+  // writes SerializedSize() bytes to out and returns their end
+  uint8_t* Serialize(uint8_t* out) const;
+  std::vector<uint8_t> Serialize() const;
+  // reads the number at the front of [first, last) and returns its end, or
+  // nullptr leaving num as it was when the bytes are truncated or the number
+  // has a leading zero limb or is a negative zero
+  friend const uint8_t* Deserialize(const uint8_t* first, const uint8_t* last,
+                                    BigInt& num);
+  friend class BigIntView;
+  friend void Add(BigInt& dest, BigIntView lhs, BigIntView rhs);
+  friend void Mul(BigInt& dest, BigIntView lhs, BigIntView rhs);
+  friend class ModContext;
 
  private:
-  std::vector<size_t> number_;
+  BigInt AddWithSign(const BigInt& num, bool num_sign) const;
+  // adds num with the given sign reusing the capacity of number_
+  void AddInPlace(const BigInt& num, bool num_sign);
+  void IncrementAbs();
+  void DecrementAbs();
+  void Normalize();
+  void AssignTerms(const LinearTerm* terms, size_t count);
+  // little-endian base 2^64 magnitude without leading zero limbs, zero is
+  // stored as an empty vector, one and two limb values stay inline
+  LimbVector number_;
   bool sign_ = true;
-  const int64_t kRank = 1e9;
-  const size_t kCountRank = 9;
 };
+
+// sum of scaled BigInt references built by Lazy() and the operators below,
+// nothing is computed until it is converted to a BigInt, so it must not
+// outlive the full expression that refers to temporaries
+template <size_t N>
+class BigIntExpr {
+ public:
+  using Owned = std::array<std::shared_ptr<const BigInt>, N>;
+  explicit BigIntExpr(const std::array<BigInt::LinearTerm, N>& terms,
+                      const Owned& owned = {})
+      : terms_(terms), owned_(owned) {}
+  const std::array<BigInt::LinearTerm, N>& Terms() const { return terms_; }
+  const Owned& OwnedValues() const { return owned_; }
+
+ private:
+  std::array<BigInt::LinearTerm, N> terms_;
+  // values evaluated while the expression was built that some terms point
+  // to, empty unless scaling a term overflowed a limb
+  Owned owned_;
+};
+
+inline BigIntExpr<1> Lazy(const BigInt& num) {
+  return BigIntExpr<1>({BigInt::LinearTerm{&num, 1, false}});
+}
+template <size_t N, size_t M>
+BigIntExpr<N + M> operator+(const BigIntExpr<N>& lhs,
+                            const BigIntExpr<M>& rhs) {
+  std::array<BigInt::LinearTerm, N + M> terms;
+  std::copy(lhs.Terms().begin(), lhs.Terms().end(), terms.begin());
+  std::copy(rhs.Terms().begin(), rhs.Terms().end(), terms.begin() + N);
+  typename BigIntExpr<N + M>::Owned owned;
+  std::copy(lhs.OwnedValues().begin(), lhs.OwnedValues().end(), owned.begin());
+  std::copy(rhs.OwnedValues().begin(), rhs.OwnedValues().end(),
+            owned.begin() + N);
+  return BigIntExpr<N + M>(terms, owned);
+}
+template <size_t N>
+BigIntExpr<N> operator-(const BigIntExpr<N>& expr) {
+  std::array<BigInt::LinearTerm, N> terms = expr.Terms();
+  for (BigInt::LinearTerm& term : terms) {
+    term.negative = !term.negative;
+  }
+  return BigIntExpr<N>(terms, expr.OwnedValues());
+}
+template <size_t N, size_t M>
+BigIntExpr<N + M> operator-(const BigIntExpr<N>& lhs,
+                            const BigIntExpr<M>& rhs) {
+  return lhs + -rhs;
+}
+template <size_t N>
+BigIntExpr<N + 1> operator+(const BigIntExpr<N>& lhs, const BigInt& rhs) {
+  return lhs + Lazy(rhs);
+}
+template <size_t N>
+BigIntExpr<N + 1> operator+(const BigInt& lhs, const BigIntExpr<N>& rhs) {
+  return Lazy(lhs) + rhs;
+}
+template <size_t N>
+BigIntExpr<N + 1> operator-(const BigIntExpr<N>& lhs, const BigInt& rhs) {
+  return lhs - Lazy(rhs);
+}
+template <size_t N>
+BigIntExpr<N + 1> operator-(const BigInt& lhs, const BigIntExpr<N>& rhs) {
+  return Lazy(lhs) - rhs;
+}
+// only single terms are scaled, a term whose scales multiply past a limb is
+// evaluated right away and kept alive by the expression
+inline BigIntExpr<1> operator*(const BigIntExpr<1>& expr, int64_t scale) {
+  BigInt::LinearTerm term = expr.Terms()[0];
+  // unsigned negation also covers the minimal int64_t
+  BigInt::Limb abs = scale >= 0 ? BigInt::Limb(scale)
+                                : BigInt::Limb(0) - BigInt::Limb(scale);
+  BigInt::Limb product;
+  if (!__builtin_mul_overflow(term.scale, abs, &product)) {
+    return BigIntExpr<1>(
+        {BigInt::LinearTerm{term.value, product, term.negative != (scale < 0)}},
+        expr.OwnedValues());
+  }
+  auto value = std::make_shared<const BigInt>(
+      BigInt(expr) * BigInt(std::vector<BigInt::Limb>{abs}));
+  return BigIntExpr<1>({BigInt::LinearTerm{value.get(), 1, scale < 0}},
+                       {value});
+}
+inline BigIntExpr<1> operator*(int64_t scale, const BigIntExpr<1>& expr) {
+  return expr * scale;
+}
+
+template <size_t N>
+BigInt::BigInt(const BigIntExpr<N>& expr) {
+  AssignTerms(expr.Terms().data(), N);
+}
+template <size_t N>
+BigInt& BigInt::operator=(const BigIntExpr<N>& expr) {
+  AssignTerms(expr.Terms().data(), N);
+  return *this;
+}
+
+// read-only number over little-endian limbs owned by someone else, such as a
+// mapped file or a BigInt, which must outlive the view and stay unchanged
+class BigIntView {
+ public:
+  using Limb = BigInt::Limb;
+  BigIntView() = default;
+  // leading zero limbs are skipped and zero is never negative
+  BigIntView(const Limb* limbs, size_t size, bool negative = false);
+  BigIntView(const BigInt& num);
+  const Limb* Data() const { return limbs_; }
+  size_t Size() const { return size_; }
+  bool IsNegative() const { return negative_; }
+  BigInt ToBigInt() const;
+  BigIntView operator-() const;
+  // -1, 0 or 1 as lhs is less than, equal to or greater than rhs
+  friend int Compare(BigIntView lhs, BigIntView rhs);
+  friend bool operator==(BigIntView lhs, BigIntView rhs) {
+    return Compare(lhs, rhs) == 0;
+  }
+  friend bool operator!=(BigIntView lhs, BigIntView rhs) {
+    return Compare(lhs, rhs) != 0;
+  }
+  friend bool operator<(BigIntView lhs, BigIntView rhs) {
+    return Compare(lhs, rhs) < 0;
+  }
+  friend bool operator>(BigIntView lhs, BigIntView rhs) {
+    return Compare(lhs, rhs) > 0;
+  }
+  friend bool operator<=(BigIntView lhs, BigIntView rhs) {
+    return Compare(lhs, rhs) <= 0;
+  }
+  friend bool operator>=(BigIntView lhs, BigIntView rhs) {
+    return Compare(lhs, rhs) >= 0;
+  }
+  // dest = lhs op rhs in the capacity dest already has, dest may be one of
+  // the viewed numbers itself
+  friend void Add(BigInt& dest, BigIntView lhs, BigIntView rhs);
+  friend void Sub(BigInt& dest, BigIntView lhs, BigIntView rhs);
+  friend void Mul(BigInt& dest, BigIntView lhs, BigIntView rhs);
+  // view of the number serialized at the front of [first, last) without
+  // copying its limbs, with the result of Deserialize; first must be 8-byte
+  // aligned and the host little-endian, otherwise the result is nullptr
+  friend const uint8_t* DeserializeView(const uint8_t* first,
+                                        const uint8_t* last, BigIntView& view);
+
+ private:
+  const Limb* limbs_ = nullptr;
+  size_t size_ = 0;
+  bool negative_ = false;
+};
+int Compare(BigIntView lhs, BigIntView rhs);
+void Add(BigInt& dest, BigIntView lhs, BigIntView rhs);
+void Sub(BigInt& dest, BigIntView lhs, BigIntView rhs);
+void Mul(BigInt& dest, BigIntView lhs, BigIntView rhs);
@@ -0,0 +1,238 @@
+#include "big_integer_batch.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+
+#include "limb_kernels.hpp"
+#include "scratch_arena.hpp"
+#include "thread_pool.hpp"
+
+using Limb = BigInt::Limb;
+
+static const Limb kTopBit = Limb(1) << 63;
+// numbers handled together through all rows, so that the rows of a block
+// stay in the cache while every row pair is combined
+static const size_t kLaneBlock = 256;
+
+// limbs num takes in two's complement
+static size_t TwosWidth(BigIntView num) {
+  size_t n = num.Size();
+  if (n == 0) {
+    return 0;
+  }
+  Limb top = num.Data()[n - 1];
+  if (top < kTopBit) {
+    return n;
+  }
+  // only -2^(64n - 1) keeps the set top bit within n limbs
+  bool power = num.IsNegative() && top == kTopBit &&
+               std::all_of(num.Data(), num.Data() + n - 1,
+                           [](Limb limb) { return limb == 0; });
+  return power ? n : n + 1;
+}
+// the sign extension of every lane of the top row, all ones for negative
+// numbers
+static void SignRow(Limb* res, const Limb* top, size_t lanes) {
+  for (size_t k = 0; k < lanes; ++k) {
+    res[k] = top == nullptr ? 0 : Limb(int64_t(top[k]) >> 63);
+  }
+}
+// body(first, last) over blocks of numbers, on the shared pool when the
+// operation touches enough limbs
+template <typename Body>
+static void ForEachBlock(size_t count, size_t work, const Body& body) {
+  std::shared_ptr<ThreadPool> pool;
+  std::optional<ThreadPool::Scope> scope;
+  if (ThreadPool::Current() == nullptr &&
+      work >= BigInt::thread_options.min_limbs) {
+    pool = ThreadPool::Shared(BigInt::thread_options.max_threads);
+  }
+  if (pool) {
+    scope.emplace(pool.get());
+  }
+  ParallelFor(count, kLaneBlock, [&](size_t first, size_t last) {
+    for (size_t block = first; block < last; block += kLaneBlock) {
+      body(block, std::min(block + kLaneBlock, last));
+    }
+  });
+}
+
+BigIntBatch::BigIntBatch(size_t count) : size_(count) {}
+BigIntBatch::BigIntBatch(const std::vector<BigInt>& nums)
+    : size_(nums.size()) {
+  size_t width = 0;
+  for (const BigInt& num : nums) {
+    width = std::max(width, TwosWidth(num));
+  }
+  Widen(width);
+  for (size_t k = 0; k < size_; ++k) {
+    Set(k, nums[k]);
+  }
+}
+BigInt BigIntBatch::Get(size_t index) const {
+  LimbVector number(width_);
+  for (size_t row = 0; row < width_; ++row) {
+    number[row] = Row(row)[index];
+  }
+  bool negative = width_ != 0 && (number[width_ - 1] & kTopBit) != 0;
+  if (negative) {
+    Limb carry = 1;
+    for (Limb& limb : number) {
+      limb = ~limb + carry;
+      carry = (carry != 0 && limb == 0) ? 1 : 0;
+    }
+  }
+  return BigInt(!negative, std::move(number));
+}
+void BigIntBatch::Set(size_t index, const BigInt& num) {
+  BigIntView view(num);
+  Widen(std::max(width_, TwosWidth(view)));
+  // the magnitude is negated on the fly for negative numbers
+  Limb carry = view.IsNegative() ? 1 : 0;
+  Limb flip = view.IsNegative() ? ~Limb(0) : 0;
+  for (size_t row = 0; row < width_; ++row) {
+    Limb limb = (row < view.Size() ? view.Data()[row] : 0) ^ flip;
+    limb += carry;
+    carry = (carry != 0 && limb == 0) ? 1 : 0;
+    Row(row)[index] = limb;
+  }
+}
+std::vector<BigInt> BigIntBatch::ToVector() const {
+  std::vector<BigInt> result;
+  result.reserve(size_);
+  for (size_t k = 0; k < size_; ++k) {
+    result.push_back(Get(k));
+  }
+  return result;
+}
+void BigIntBatch::Widen(size_t width) {
+  if (width <= width_) {
+    return;
+  }
+  limbs_.resize(width * size_);
+  if (width_ != 0) {
+    for (size_t row = width_; row < width; ++row) {
+      SignRow(Row(row), Row(width_ - 1), size_);
+    }
+  }
+  width_ = width;
+}
+void BigIntBatch::Trim() {
+  while (width_ > 0) {
+    const Limb* top = Row(width_ - 1);
+    bool redundant = true;
+    for (size_t k = 0; k < size_ && redundant; ++k) {
+      Limb sign = width_ > 1 ? Limb(int64_t(Row(width_ - 2)[k]) >> 63) : 0;
+      redundant = top[k] == sign;
+    }
+    if (!redundant) {
+      break;
+    }
+    --width_;
+  }
+  limbs_.resize(width_ * size_);
+}
+
+// two's complement sums need one row more than the wider operand and never
+// overflow it, the carries out of the top row are dropped
+template <typename Kernel>
+static void AddRows(std::vector<Limb>& result, size_t width,
+                    const std::vector<Limb>& lhs, size_t lhs_width,
+                    const std::vector<Limb>& rhs, size_t rhs_width,
+                    size_t count, const Kernel& kernel) {
+  result.assign(width * count, 0);
+  ForEachBlock(count, width * count, [&](size_t first, size_t last) {
+    size_t lanes = last - first;
+    ScratchArena::Frame frame;
+    Limb* carry = frame.Allocate<Limb>(lanes);
+    Limb* lhs_sign = frame.Allocate<Limb>(lanes);
+    Limb* rhs_sign = frame.Allocate<Limb>(lanes);
+    std::fill(carry, carry + lanes, 0);
+    SignRow(lhs_sign,
+            lhs_width == 0 ? nullptr : &lhs[(lhs_width - 1) * count + first],
+            lanes);
+    SignRow(rhs_sign,
+            rhs_width == 0 ? nullptr : &rhs[(rhs_width - 1) * count + first],
+            lanes);
+    for (size_t row = 0; row < width; ++row) {
+      const Limb* left =
+          row < lhs_width ? &lhs[row * count + first] : lhs_sign;
+      const Limb* right =
+          row < rhs_width ? &rhs[row * count + first] : rhs_sign;
+      kernel(&result[row * count + first], left, right, carry, lanes);
+    }
+  });
+}
+void Add(BigIntBatch& dest, const BigIntBatch& lhs, const BigIntBatch& rhs) {
+  std::vector<Limb> result;
+  size_t width = std::max(lhs.width_, rhs.width_) + 1;
+  AddRows(result, width, lhs.limbs_, lhs.width_, rhs.limbs_, rhs.width_,
+          lhs.size_, LimbLanesAdd);
+  dest.limbs_ = std::move(result);
+  dest.size_ = lhs.size_;
+  dest.width_ = width;
+  dest.Trim();
+}
+void Sub(BigIntBatch& dest, const BigIntBatch& lhs, const BigIntBatch& rhs) {
+  std::vector<Limb> result;
+  size_t width = std::max(lhs.width_, rhs.width_) + 1;
+  AddRows(result, width, lhs.limbs_, lhs.width_, rhs.limbs_, rhs.width_,
+          lhs.size_, LimbLanesSub);
+  dest.limbs_ = std::move(result);
+  dest.size_ = lhs.size_;
+  dest.width_ = width;
+  dest.Trim();
+}
+// schoolbook on the rows of the unsigned two's complement forms, which is
+// too large by rhs * 2^(64 lhs_width) when lhs is negative and likewise for
+// rhs, the masked rows take these back off
+void Mul(BigIntBatch& dest, const BigIntBatch& lhs, const BigIntBatch& rhs) {
+  size_t count = lhs.size_;
+  size_t lhs_width = lhs.width_;
+  size_t rhs_width = rhs.width_;
+  if (lhs_width == 0 || rhs_width == 0) {
+    dest = BigIntBatch(count);
+    return;
+  }
+  size_t width = lhs_width + rhs_width;
+  std::vector<Limb> result(width * count, 0);
+  ForEachBlock(count, lhs_width * rhs_width * count, [&](size_t first,
+                                                         size_t last) {
+    size_t lanes = last - first;
+    ScratchArena::Frame frame;
+    Limb* carry = frame.Allocate<Limb>(lanes);
+    Limb* masked = frame.Allocate<Limb>(lanes);
+    Limb* lhs_sign = frame.Allocate<Limb>(lanes);
+    Limb* rhs_sign = frame.Allocate<Limb>(lanes);
+    auto res_row = [&](size_t row) { return &result[row * count + first]; };
+    SignRow(lhs_sign, lhs.Row(lhs_width - 1) + first, lanes);
+    SignRow(rhs_sign, rhs.Row(rhs_width - 1) + first, lanes);
+    for (size_t i = 0; i < lhs_width; ++i) {
+      std::fill(carry, carry + lanes, 0);
+      for (size_t j = 0; j < rhs_width; ++j) {
+        LimbLanesMulAdd(res_row(i + j), carry, lhs.Row(i) + first,
+                        rhs.Row(j) + first, lanes);
+      }
+      std::copy(carry, carry + lanes, res_row(i + rhs_width));
+    }
+    auto correct = [&](const BigIntBatch& num, size_t offset,
+                       const Limb* mask) {
+      std::fill(carry, carry + lanes, 0);
+      for (size_t row = 0; row < num.width_; ++row) {
+        const Limb* limbs = num.Row(row) + first;
+        for (size_t k = 0; k < lanes; ++k) {
+          masked[k] = limbs[k] & mask[k];
+        }
+        LimbLanesSub(res_row(offset + row), res_row(offset + row), masked,
+                     carry, lanes);
+      }
+    };
+    correct(rhs, lhs_width, lhs_sign);
+    correct(lhs, rhs_width, rhs_sign);
+  });
+  dest.limbs_ = std::move(result);
+  dest.size_ = count;
+  dest.width_ = width;
+  dest.Trim();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "big_integer.hpp"
+// many numbers in one structure-of-arrays buffer: row i holds limb i of
+// every number, so the lane kernels step through all of them together, and
+// each number is kept in two's complement over Width() limbs, which makes
+// addition and subtraction the same branch-free code for every sign
+class BigIntBatch {
+ public:
+  using Limb = BigInt::Limb;
+  BigIntBatch() = default;
+  // count zeros
+  explicit BigIntBatch(size_t count);
+  explicit BigIntBatch(const std::vector<BigInt>& nums);
+  size_t Size() const { return size_; }
+  // limbs per number, enough for the widest one and its sign
+  size_t Width() const { return width_; }
+  BigInt Get(size_t index) const;
+  // widens the whole batch when num does not fit
+  void Set(size_t index, const BigInt& num);
+  std::vector<BigInt> ToVector() const;
+
+  // dest[k] = lhs[k] op rhs[k] for operands of the same size, dest may be
+  // one of them; batches of at least BigInt::thread_options.min_limbs limbs
+  // of work spread their numbers over the shared pool
+  friend void Add(BigIntBatch& dest, const BigIntBatch& lhs,
+                  const BigIntBatch& rhs);
+  friend void Sub(BigIntBatch& dest, const BigIntBatch& lhs,
+                  const BigIntBatch& rhs);
+  friend void Mul(BigIntBatch& dest, const BigIntBatch& lhs,
+                  const BigIntBatch& rhs);
+
+ private:
+  const Limb* Row(size_t row) const { return limbs_.data() + row * size_; }
+  Limb* Row(size_t row) { return limbs_.data() + row * size_; }
+  // drops top rows that only repeat the sign of the row below
+  void Trim();
+  void Widen(size_t width);
+
+  // Width() rows of Size() limbs
+  std::vector<Limb> limbs_;
+  size_t size_ = 0;
+  size_t width_ = 0;
+};
+void Add(BigIntBatch& dest, const BigIntBatch& lhs, const BigIntBatch& rhs);
+void Sub(BigIntBatch& dest, const BigIntBatch& lhs, const BigIntBatch& rhs);
+void Mul(BigIntBatch& dest, const BigIntBatch& lhs, const BigIntBatch& rhs);
@@ -0,0 +1,208 @@
+#include "big_rational.hpp"
+
+#include <algorithm>
+
+#include "number_theory.hpp"
+
+using Limb = BigInt::Limb;
+
+static const size_t kLimbBits = 64;
+static const Limb kBlockScale = 10000000000000000000ULL;
+
+BigRational::BigRational(int64_t num) : num_(num) {}
+BigRational::BigRational(const BigInt& num) : num_(num) {}
+BigRational::BigRational(const BigInt& num, const BigInt& den) {
+  if (den == BigInt(0)) {
+    return;
+  }
+  bool flip = den < BigInt(0);
+  num_ = flip ? -num : num;
+  den_ = flip ? -den : den;
+  reduced_ = false;
+  Normalize();
+}
+BigRational::BigRational(const std::string& number) {
+  size_t slash = number.find('/');
+  if (slash == std::string::npos) {
+    num_ = BigInt(number);
+    return;
+  }
+  *this = BigRational(BigInt(number.substr(0, slash)),
+                      BigInt(number.substr(slash + 1)));
+}
+BigRational BigRational::Unreduced(BigInt&& num, BigInt&& den, size_t bits) {
+  BigRational result;
+  result.num_ = std::move(num);
+  result.den_ = std::move(den);
+  result.reduced_ = result.den_ == BigInt(1);
+  result.reduced_bits_ = bits;
+  if (result.den_.BitLength() > kReduceGrowth * std::max(bits, kLimbBits)) {
+    result.Normalize();
+  }
+  return result;
+}
+void BigRational::Normalize() {
+  if (reduced_) {
+    return;
+  }
+  BigInt gcd = Gcd(num_, den_);
+  if (gcd != BigInt(1)) {
+    num_ /= gcd;
+    den_ /= gcd;
+  }
+  reduced_ = true;
+  reduced_bits_ = den_.BitLength();
+}
+BigRational BigRational::Reduced() const {
+  BigRational result = *this;
+  result.Normalize();
+  return result;
+}
+BigInt BigRational::Numerator() const {
+  return reduced_ ? num_ : Reduced().num_;
+}
+BigInt BigRational::Denominator() const {
+  return reduced_ ? den_ : Reduced().den_;
+}
+int BigRational::Sign() const {
+  if (num_ == BigInt(0)) {
+    return 0;
+  }
+  return num_ < BigInt(0) ? -1 : 1;
+}
+
+/* arithmetic */
+BigRational BigRational::operator+(const BigRational& num) const {
+  size_t bits = std::max(reduced_bits_, num.reduced_bits_);
+  if (den_ == num.den_) {
+    return Unreduced(num_ + num.num_, BigInt(den_), bits);
+  }
+  return Unreduced(num_ * num.den_ + num.num_ * den_, den_ * num.den_, bits);
+}
+BigRational BigRational::operator-(const BigRational& num) const {
+  return *this + -num;
+}
+BigRational BigRational::operator*(const BigRational& num) const {
+  return Unreduced(num_ * num.num_, den_ * num.den_,
+                   std::max(reduced_bits_, num.reduced_bits_));
+}
+BigRational BigRational::operator/(const BigRational& num) const {
+  if (num.num_ == BigInt(0)) {
+    return BigRational();
+  }
+  BigInt res_num = num_ * num.den_;
+  BigInt res_den = den_ * num.num_;
+  if (res_den < BigInt(0)) {
+    res_num = -res_num;
+    res_den = -res_den;
+  }
+  return Unreduced(std::move(res_num), std::move(res_den),
+                   std::max(reduced_bits_, num.reduced_bits_));
+}
+BigRational BigRational::operator-() const {
+  BigRational result = *this;
+  result.num_ = -result.num_;
+  return result;
+}
+BigRational& BigRational::operator+=(const BigRational& num) {
+  return *this = *this + num;
+}
+BigRational& BigRational::operator-=(const BigRational& num) {
+  return *this = *this - num;
+}
+BigRational& BigRational::operator*=(const BigRational& num) {
+  return *this = *this * num;
+}
+BigRational& BigRational::operator/=(const BigRational& num) {
+  return *this = *this / num;
+}
+
+/* comparison and output */
+int BigRational::Compare(const BigRational& num) const {
+  int lhs_sign = Sign();
+  int rhs_sign = num.Sign();
+  if (lhs_sign != rhs_sign) {
+    return lhs_sign < rhs_sign ? -1 : 1;
+  }
+  if (den_ == num.den_) {
+    return num_ < num.num_ ? -1 : (num.num_ < num_ ? 1 : 0);
+  }
+  BigInt lhs = num_ * num.den_;
+  BigInt rhs = num.num_ * den_;
+  return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+bool BigRational::operator==(const BigRational& num) const {
+  return Compare(num) == 0;
+}
+bool BigRational::operator!=(const BigRational& num) const {
+  return Compare(num) != 0;
+}
+bool BigRational::operator<(const BigRational& num) const {
+  return Compare(num) < 0;
+}
+bool BigRational::operator>(const BigRational& num) const {
+  return Compare(num) > 0;
+}
+bool BigRational::operator<=(const BigRational& num) const {
+  return Compare(num) <= 0;
+}
+bool BigRational::operator>=(const BigRational& num) const {
+  return Compare(num) >= 0;
+}
+std::string BigRational::ToString() const {
+  if (!reduced_) {
+    return Reduced().ToString();
+  }
+  if (den_ == BigInt(1)) {
+    return num_.ToString();
+  }
+  return num_.ToString() + "/" + den_.ToString();
+}
+std::ostream& operator<<(std::ostream& os, const BigRational& out) {
+  return os << out.ToString();
+}
+
+/* digit generation */
+DecimalExpansion::DecimalExpansion(const BigRational& value)
+    : negative_(value.Sign() < 0) {
+  BigRational reduced = value.Reduced();
+  den_ = reduced.Denominator();
+  auto [quot, rem] = reduced.Numerator().DivMod(den_);
+  integer_ = negative_ ? -quot : quot;
+  remainder_ = negative_ ? -rem : rem;
+}
+void DecimalExpansion::Refill() {
+  auto [quot, rem] =
+      (remainder_ * BigInt(std::vector<Limb>{kBlockScale})).DivMod(den_);
+  Limb digits = quot.ToInt();
+  for (size_t k = kBlockDigits; k-- > 0;) {
+    block_[k] = char('0' + digits % 10);
+    digits /= 10;
+  }
+  remainder_ = std::move(rem);
+  position_ = 0;
+}
+int DecimalExpansion::Next() {
+  if (position_ == kBlockDigits) {
+    Refill();
+  }
+  return block_[position_++] - '0';
+}
+std::string DecimalExpansion::Next(size_t count) {
+  std::string digits;
+  digits.reserve(count);
+  while (digits.size() < count) {
+    if (position_ == kBlockDigits) {
+      Refill();
+    }
+    size_t take = std::min(count - digits.size(), kBlockDigits - position_);
+    digits.append(block_ + position_, take);
+    position_ += take;
+  }
+  return digits;
+}
+bool DecimalExpansion::Terminated() const {
+  return remainder_ == BigInt(0) &&
+         std::all_of(block_ + position_, block_ + kBlockDigits,
+                     [](char digit) { return digit == '0'; });
+}
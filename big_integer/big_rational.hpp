@@ -0,0 +1,90 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#include "big_integer.hpp"
+// exact fraction with a positive denominator; arithmetic leaves results
+// unreduced and the gcd is only taken in place by Normalize or once the
+// terms have grown kReduceGrowth times past their size at the last
+// reduction, const members reduce a copy, so reading a shared value from
+// several threads is safe
+class BigRational {
+ public:
+  BigRational() = default;
+  BigRational(int64_t num);
+  BigRational(const BigInt& num);
+  // zero for a zero denominator
+  BigRational(const BigInt& num, const BigInt& den);
+  // "p" or "p/q" in decimal
+  explicit BigRational(const std::string& number);
+  // the terms in lowest terms, an unreduced value computes them on a copy
+  BigInt Numerator() const;
+  BigInt Denominator() const;
+  BigRational Reduced() const;
+  // reduces the stored terms
+  void Normalize();
+  int Sign() const;
+
+  BigRational operator+(const BigRational& num) const;
+  BigRational operator-(const BigRational& num) const;
+  BigRational operator*(const BigRational& num) const;
+  // zero when num is zero
+  BigRational operator/(const BigRational& num) const;
+  BigRational operator-() const;
+  BigRational& operator+=(const BigRational& num);
+  BigRational& operator-=(const BigRational& num);
+  BigRational& operator*=(const BigRational& num);
+  BigRational& operator/=(const BigRational& num);
+  // by cross multiplication, neither side gets reduced
+  bool operator==(const BigRational& num) const;
+  bool operator!=(const BigRational& num) const;
+  bool operator<(const BigRational& num) const;
+  bool operator>(const BigRational& num) const;
+  bool operator<=(const BigRational& num) const;
+  bool operator>=(const BigRational& num) const;
+  // "p/q" in lowest terms, "p" for integers
+  std::string ToString() const;
+  friend std::ostream& operator<<(std::ostream& os, const BigRational& out);
+
+ private:
+  // the denominators may grow this many times past the reduced size
+  static const size_t kReduceGrowth = 4;
+  // a result of num / den that is reduced once it grows too large
+  static BigRational Unreduced(BigInt&& num, BigInt&& den, size_t bits);
+  int Compare(const BigRational& num) const;
+
+  BigInt num_;
+  BigInt den_ = BigInt(1);
+  bool reduced_ = true;
+  // bits of the denominator after the last reduction
+  size_t reduced_bits_ = 1;
+};
+
+// decimal digits of a fraction after the point, generated by long division
+// that keeps only the remainder, so reading n digits of p/q costs about
+// n / 19 divisions of a number one limb longer than q and nothing grows
+class DecimalExpansion {
+ public:
+  explicit DecimalExpansion(const BigRational& value);
+  bool IsNegative() const { return negative_; }
+  // the value rounded towards zero, without its sign
+  const BigInt& IntegerPart() const { return integer_; }
+  // the next digit, 0 to 9
+  int Next();
+  std::string Next(size_t count);
+  // true once every remaining digit is zero
+  bool Terminated() const;
+
+ private:
+  // one limb worth of digits per division
+  static const size_t kBlockDigits = 19;
+  void Refill();
+
+  bool negative_;
+  BigInt integer_;
+  BigInt remainder_;
+  BigInt den_;
+  char block_[kBlockDigits];
+  size_t position_ = kBlockDigits;
+};
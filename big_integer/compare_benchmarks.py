@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Compares two JSON outputs of big_integer_benchmark.
+
+Usage: compare_benchmarks.py baseline.json current.json [--threshold 0.1]
+
+Prints the relative change of the time per iteration for every benchmark
+present in both files and exits with status 1 when any of them got slower
+by more than the threshold. With --benchmark_repetitions the medians are
+compared instead of the single runs.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load_times(path):
+    with open(path) as file:
+        benchmarks = json.load(file)["benchmarks"]
+    medians = {
+        bench["run_name"]: bench["real_time"]
+        for bench in benchmarks
+        if bench.get("aggregate_name") == "median"
+    }
+    if medians:
+        return medians
+    return {
+        bench["name"]: bench["real_time"]
+        for bench in benchmarks
+        if bench.get("run_type", "iteration") == "iteration"
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="largest tolerated slowdown, 0.1 is 10%%")
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline)
+    current = load_times(args.current)
+    regressions = []
+    width = max((len(name) for name in current), default=0)
+    for name, time in current.items():
+        if name not in baseline or baseline[name] == 0:
+            continue
+        change = time / baseline[name] - 1
+        mark = ""
+        if change > args.threshold:
+            regressions.append(name)
+            mark = "  REGRESSION"
+        print(f"{name:<{width}}  {baseline[name]:>14.3f}  {time:>14.3f}"
+              f"  {change:>+8.1%}{mark}")
+    missing = sorted(set(baseline) - set(current))
+    for name in missing:
+        print(f"{name:<{width}}  missing from {args.current}")
+    if regressions:
+        print(f"{len(regressions)} of {len(current)} benchmarks slower by "
+              f"more than {args.threshold:.0%}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,420 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "big_integer.hpp"
+// unsigned integer of exactly Bits bits with arithmetic modulo 2^Bits like
+// the built-in unsigned types; the limbs live in a std::array inside the
+// object and everything but the BigInt conversions is constexpr, so none of
+// it allocates
+template <size_t Bits>
+class FixedBigInt {
+  static_assert(Bits > 0 && Bits % 64 == 0,
+                "Bits must be a positive multiple of the limb width");
+
+ public:
+  using Limb = BigInt::Limb;
+  static constexpr size_t kLimbs = Bits / 64;
+  using Limbs = std::array<Limb, kLimbs>;
+
+  constexpr FixedBigInt() = default;
+  // built-in integers convert as they do to the built-in unsigned types, a
+  // negative value is sign-extended to 2^Bits - |value|
+  template <std::unsigned_integral T>
+  constexpr FixedBigInt(T value) : limbs_{Limb(value)} {}
+  template <std::signed_integral T>
+  constexpr FixedBigInt(T value) {
+    limbs_.fill(value < 0 ? ~Limb(0) : 0);
+    limbs_[0] = Limb(value);
+  }
+  // little-endian limbs
+  constexpr explicit FixedBigInt(const Limbs& limbs) : limbs_(limbs) {}
+  // decimal or 0x-prefixed hexadecimal digits up to the first other
+  // character, reduced modulo 2^Bits
+  constexpr explicit FixedBigInt(std::string_view digits) {
+    Limb base = 10;
+    if (digits.size() > 2 && digits[0] == '0' &&
+        (digits[1] == 'x' || digits[1] == 'X')) {
+      base = 16;
+      digits.remove_prefix(2);
+    }
+    for (char digit : digits) {
+      Limb value = DigitValue(digit);
+      if (value >= base) {
+        break;
+      }
+      MulAddLimb(base, value);
+    }
+  }
+  // num modulo 2^Bits, so negative numbers wrap around as two's complement
+  explicit FixedBigInt(BigIntView num) {
+    for (size_t i = 0; i < kLimbs && i < num.Size(); ++i) {
+      limbs_[i] = num.Data()[i];
+    }
+    if (num.IsNegative()) {
+      *this = -*this;
+    }
+  }
+  BigInt ToBigInt() const {
+    return BigInt(true, LimbVector(limbs_.data(), limbs_.data() + kLimbs));
+  }
+  std::string ToString() const { return ToBigInt().ToString(); }
+  constexpr const Limbs& GetLimbs() const { return limbs_; }
+
+  constexpr FixedBigInt& operator+=(const FixedBigInt& num) {
+    Limb carry = 0;
+    Unroll<kLimbs>([&](size_t i) {
+      Limb sum = limbs_[i] + carry;
+      carry = sum < carry ? 1 : 0;
+      limbs_[i] = sum + num.limbs_[i];
+      carry += limbs_[i] < sum ? 1 : 0;
+    });
+    return *this;
+  }
+  constexpr FixedBigInt& operator-=(const FixedBigInt& num) {
+    Limb borrow = 0;
+    Unroll<kLimbs>([&](size_t i) {
+      Limb cur = limbs_[i];
+      Limb diff = cur - num.limbs_[i];
+      Limb next = (cur < num.limbs_[i] || diff < borrow) ? 1 : 0;
+      limbs_[i] = diff - borrow;
+      borrow = next;
+    });
+    return *this;
+  }
+  // schoolbook product of the limbs below 2^Bits
+  constexpr FixedBigInt& operator*=(const FixedBigInt& num) {
+    Limbs result{};
+    Unroll<kLimbs>([&](size_t i) {
+      DoubleLimb carry = 0;
+      for (size_t j = 0; i + j < kLimbs; ++j) {
+        carry += DoubleLimb(limbs_[i]) * num.limbs_[j] + result[i + j];
+        result[i + j] = Limb(carry);
+        carry >>= 64;
+      }
+    });
+    limbs_ = result;
+    return *this;
+  }
+  constexpr FixedBigInt& operator/=(const FixedBigInt& num) {
+    return *this = DivMod(*this, num).first;
+  }
+  constexpr FixedBigInt& operator%=(const FixedBigInt& num) {
+    return *this = DivMod(*this, num).second;
+  }
+  constexpr FixedBigInt& operator&=(const FixedBigInt& num) {
+    Unroll<kLimbs>([&](size_t i) { limbs_[i] &= num.limbs_[i]; });
+    return *this;
+  }
+  constexpr FixedBigInt& operator|=(const FixedBigInt& num) {
+    Unroll<kLimbs>([&](size_t i) { limbs_[i] |= num.limbs_[i]; });
+    return *this;
+  }
+  constexpr FixedBigInt& operator^=(const FixedBigInt& num) {
+    Unroll<kLimbs>([&](size_t i) { limbs_[i] ^= num.limbs_[i]; });
+    return *this;
+  }
+  // shifts by Bits or more give zero
+  constexpr FixedBigInt& operator<<=(size_t bits) {
+    size_t limbs = bits / 64;
+    size_t shift = bits % 64;
+    for (size_t i = kLimbs; i-- > 0;) {
+      Limb cur = 0;
+      if (i >= limbs) {
+        cur = limbs_[i - limbs] << shift;
+        if (shift != 0 && i > limbs) {
+          cur |= limbs_[i - limbs - 1] >> (64 - shift);
+        }
+      }
+      limbs_[i] = cur;
+    }
+    return *this;
+  }
+  constexpr FixedBigInt& operator>>=(size_t bits) {
+    size_t limbs = bits / 64;
+    size_t shift = bits % 64;
+    for (size_t i = 0; i < kLimbs; ++i) {
+      Limb cur = 0;
+      if (i + limbs < kLimbs) {
+        cur = limbs_[i + limbs] >> shift;
+        if (shift != 0 && i + limbs + 1 < kLimbs) {
+          cur |= limbs_[i + limbs + 1] << (64 - shift);
+        }
+      }
+      limbs_[i] = cur;
+    }
+    return *this;
+  }
+  constexpr FixedBigInt& operator++() { return *this += 1; }
+  constexpr FixedBigInt& operator--() { return *this -= 1; }
+  constexpr FixedBigInt operator++(int) {
+    FixedBigInt tmp = *this;
+    ++*this;
+    return tmp;
+  }
+  constexpr FixedBigInt operator--(int) {
+    FixedBigInt tmp = *this;
+    --*this;
+    return tmp;
+  }
+  constexpr FixedBigInt operator~() const {
+    FixedBigInt result;
+    Unroll<kLimbs>([&](size_t i) { result.limbs_[i] = ~limbs_[i]; });
+    return result;
+  }
+  constexpr FixedBigInt operator-() const { return ~*this + 1; }
+
+  friend constexpr FixedBigInt operator+(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs += rhs;
+  }
+  friend constexpr FixedBigInt operator-(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs -= rhs;
+  }
+  friend constexpr FixedBigInt operator*(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs *= rhs;
+  }
+  friend constexpr FixedBigInt operator/(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs /= rhs;
+  }
+  friend constexpr FixedBigInt operator%(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs %= rhs;
+  }
+  friend constexpr FixedBigInt operator&(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs &= rhs;
+  }
+  friend constexpr FixedBigInt operator|(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs |= rhs;
+  }
+  friend constexpr FixedBigInt operator^(FixedBigInt lhs,
+                                         const FixedBigInt& rhs) {
+    return lhs ^= rhs;
+  }
+  friend constexpr FixedBigInt operator<<(FixedBigInt lhs, size_t bits) {
+    return lhs <<= bits;
+  }
+  friend constexpr FixedBigInt operator>>(FixedBigInt lhs, size_t bits) {
+    return lhs >>= bits;
+  }
+  friend constexpr bool operator==(const FixedBigInt& lhs,
+                                   const FixedBigInt& rhs) {
+    return lhs.limbs_ == rhs.limbs_;
+  }
+  friend constexpr bool operator!=(const FixedBigInt& lhs,
+                                   const FixedBigInt& rhs) {
+    return !(lhs == rhs);
+  }
+  friend constexpr bool operator<(const FixedBigInt& lhs,
+                                  const FixedBigInt& rhs) {
+    return Compare(lhs, rhs) < 0;
+  }
+  friend constexpr bool operator>(const FixedBigInt& lhs,
+                                  const FixedBigInt& rhs) {
+    return Compare(lhs, rhs) > 0;
+  }
+  friend constexpr bool operator<=(const FixedBigInt& lhs,
+                                   const FixedBigInt& rhs) {
+    return Compare(lhs, rhs) <= 0;
+  }
+  friend constexpr bool operator>=(const FixedBigInt& lhs,
+                                   const FixedBigInt& rhs) {
+    return Compare(lhs, rhs) >= 0;
+  }
+  friend std::ostream& operator<<(std::ostream& os, const FixedBigInt& out) {
+    return os << out.ToBigInt();
+  }
+
+  // the full product of two Bits-bit numbers
+  constexpr FixedBigInt<2 * Bits> MulWide(const FixedBigInt& num) const {
+    std::array<Limb, 2 * kLimbs> result{};
+    Unroll<kLimbs>([&](size_t i) {
+      DoubleLimb carry = 0;
+      for (size_t j = 0; j < kLimbs; ++j) {
+        carry += DoubleLimb(limbs_[i]) * num.limbs_[j] + result[i + j];
+        result[i + j] = Limb(carry);
+        carry >>= 64;
+      }
+      result[i + kLimbs] = Limb(carry);
+    });
+    return FixedBigInt<2 * Bits>(result);
+  }
+  // quotient and remainder by Knuth's algorithm D, both are zero when den is
+  // zero
+  static constexpr std::pair<FixedBigInt, FixedBigInt> DivMod(
+      const FixedBigInt& num, const FixedBigInt& den);
+  constexpr size_t BitLength() const {
+    size_t n = UsedLimbs();
+    return n == 0 ? 0 : n * 64 - std::countl_zero(limbs_[n - 1]);
+  }
+  constexpr size_t PopCount() const {
+    size_t count = 0;
+    Unroll<kLimbs>([&](size_t i) { count += std::popcount(limbs_[i]); });
+    return count;
+  }
+  constexpr bool TestBit(size_t bit) const {
+    return bit < Bits && ((limbs_[bit / 64] >> (bit % 64)) & 1) != 0;
+  }
+
+ private:
+  __extension__ using DoubleLimb = unsigned __int128;
+  // widths up to this many limbs get their limb loops written out by
+  // the template, wider ones keep ordinary loops
+  static constexpr size_t kMaxUnrolled = 16;
+
+  template <typename Body, size_t... I>
+  static constexpr void UnrollIndices(Body& body, std::index_sequence<I...>) {
+    (body(I), ...);
+  }
+  template <size_t N, typename Body>
+  static constexpr void Unroll(Body&& body) {
+    if constexpr (N <= kMaxUnrolled) {
+      UnrollIndices(body, std::make_index_sequence<N>());
+    } else {
+      for (size_t i = 0; i < N; ++i) {
+        body(i);
+      }
+    }
+  }
+  static constexpr Limb DigitValue(char digit) {
+    if (digit >= '0' && digit <= '9') {
+      return Limb(digit - '0');
+    }
+    if (digit >= 'a' && digit <= 'f') {
+      return Limb(digit - 'a' + 10);
+    }
+    if (digit >= 'A' && digit <= 'F') {
+      return Limb(digit - 'A' + 10);
+    }
+    return 16;
+  }
+  static constexpr int Compare(const FixedBigInt& lhs, const FixedBigInt& rhs) {
+    for (size_t i = kLimbs; i-- > 0;) {
+      if (lhs.limbs_[i] != rhs.limbs_[i]) {
+        return lhs.limbs_[i] < rhs.limbs_[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+  constexpr size_t UsedLimbs() const {
+    size_t n = kLimbs;
+    while (n > 0 && limbs_[n - 1] == 0) {
+      --n;
+    }
+    return n;
+  }
+  // *this = *this * mult + add
+  constexpr void MulAddLimb(Limb mult, Limb add) {
+    DoubleLimb carry = add;
+    Unroll<kLimbs>([&](size_t i) {
+      carry += DoubleLimb(limbs_[i]) * mult;
+      limbs_[i] = Limb(carry);
+      carry >>= 64;
+    });
+  }
+  // *this /= div, returns the remainder
+  constexpr Limb DivRemLimb(Limb div) {
+    DoubleLimb rem = 0;
+    for (size_t i = kLimbs; i-- > 0;) {
+      DoubleLimb cur = (rem << 64) | limbs_[i];
+      limbs_[i] = Limb(cur / div);
+      rem = cur % div;
+    }
+    return Limb(rem);
+  }
+
+  Limbs limbs_{};
+};
+
+template <size_t Bits>
+constexpr std::pair<FixedBigInt<Bits>, FixedBigInt<Bits>>
+FixedBigInt<Bits>::DivMod(const FixedBigInt& num, const FixedBigInt& den) {
+  size_t dn = den.UsedLimbs();
+  size_t nn = num.UsedLimbs();
+  if (dn == 0) {
+    return {};
+  }
+  if (nn < dn) {
+    return {FixedBigInt(), num};
+  }
+  if (dn == 1) {
+    FixedBigInt quot = num;
+    Limb rem = quot.DivRemLimb(den.limbs_[0]);
+    return {quot, FixedBigInt(rem)};
+  }
+  // both are shifted until the top bit of the divisor is set, the dividend
+  // gets an extra top limb for the bits shifted out
+  size_t shift = std::countl_zero(den.limbs_[dn - 1]);
+  std::array<Limb, kLimbs + 1> rem{};
+  Limbs div{};
+  for (size_t i = 0; i < nn; ++i) {
+    rem[i] |= num.limbs_[i] << shift;
+    rem[i + 1] = shift == 0 ? 0 : num.limbs_[i] >> (64 - shift);
+  }
+  for (size_t i = 0; i < dn; ++i) {
+    div[i] = den.limbs_[i] << shift;
+    if (shift != 0 && i > 0) {
+      div[i] |= den.limbs_[i - 1] >> (64 - shift);
+    }
+  }
+  FixedBigInt quot;
+  for (size_t j = nn - dn + 1; j-- > 0;) {
+    // the estimate from the top two limbs is at most two too large
+    DoubleLimb top = (DoubleLimb(rem[j + dn]) << 64) | rem[j + dn - 1];
+    DoubleLimb qhat = top / div[dn - 1];
+    DoubleLimb rhat = top % div[dn - 1];
+    while ((qhat >> 64) != 0 ||
+           qhat * div[dn - 2] > ((rhat << 64) | rem[j + dn - 2])) {
+      --qhat;
+      rhat += div[dn - 1];
+      if ((rhat >> 64) != 0) {
+        break;
+      }
+    }
+    Limb borrow = 0;
+    Limb carry = 0;
+    for (size_t i = 0; i < dn; ++i) {
+      DoubleLimb product = qhat * div[i] + carry;
+      carry = Limb(product >> 64);
+      Limb low = Limb(product);
+      Limb cur = rem[i + j];
+      Limb next = (cur < low || cur - low < borrow) ? 1 : 0;
+      rem[i + j] = cur - low - borrow;
+      borrow = next;
+    }
+    Limb cur = rem[j + dn];
+    rem[j + dn] = cur - carry - borrow;
+    if (cur < carry || cur - carry < borrow) {
+      // one subtraction too many, the divisor is added back
+      --qhat;
+      Limb add_carry = 0;
+      for (size_t i = 0; i < dn; ++i) {
+        Limb sum = rem[i + j] + add_carry;
+        add_carry = sum < add_carry ? 1 : 0;
+        rem[i + j] = sum + div[i];
+        add_carry += rem[i + j] < sum ? 1 : 0;
+      }
+      rem[j + dn] += add_carry;
+    }
+    quot.limbs_[j] = Limb(qhat);
+  }
+  FixedBigInt remainder;
+  for (size_t i = 0; i < dn; ++i) {
+    remainder.limbs_[i] = rem[i] >> shift;
+    if (shift != 0) {
+      remainder.limbs_[i] |= rem[i + 1] << (64 - shift);
+    }
+  }
+  return {quot, remainder};
+}
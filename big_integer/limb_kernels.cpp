@@ -0,0 +1,485 @@
+#include "limb_kernels.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LIMB_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+using Limb = uint64_t;
+__extension__ using DoubleLimb = unsigned __int128;
+
+static const size_t kLimbBits = 64;
+
+struct LimbKernels {
+  LimbIsa isa;
+  Limb (*add_n)(Limb* res, const Limb* lhs, const Limb* rhs, size_t n);
+  Limb (*sub_n)(Limb* res, const Limb* lhs, const Limb* rhs, size_t n);
+  int (*compare_n)(const Limb* lhs, const Limb* rhs, size_t n);
+  Limb (*mul_word)(Limb* res, const Limb* lhs, size_t n, Limb mult);
+  void (*lanes_add)(Limb* res, const Limb* lhs, const Limb* rhs, Limb* carry,
+                    size_t n);
+  void (*lanes_sub)(Limb* res, const Limb* lhs, const Limb* rhs, Limb* borrow,
+                    size_t n);
+  void (*lanes_mul_add)(Limb* res, Limb* carry, const Limb* lhs,
+                        const Limb* rhs, size_t n);
+};
+
+/* scalar kernels, also finish the tails of the vector ones */
+static Limb AddNScalar(Limb* res, const Limb* lhs, const Limb* rhs, size_t n,
+                       Limb carry) {
+  for (size_t i = 0; i < n; ++i) {
+    DoubleLimb sum = DoubleLimb(lhs[i]) + rhs[i] + carry;
+    res[i] = Limb(sum);
+    carry = Limb(sum >> kLimbBits);
+  }
+  return carry;
+}
+static Limb SubNScalar(Limb* res, const Limb* lhs, const Limb* rhs, size_t n,
+                       Limb borrow) {
+  for (size_t i = 0; i < n; ++i) {
+    Limb diff = lhs[i] - rhs[i];
+    Limb next_borrow = (lhs[i] < rhs[i] || diff < borrow) ? 1 : 0;
+    res[i] = diff - borrow;
+    borrow = next_borrow;
+  }
+  return borrow;
+}
+static int CompareNScalar(const Limb* lhs, const Limb* rhs, size_t n) {
+  for (size_t i = n; i > 0; --i) {
+    if (lhs[i - 1] != rhs[i - 1]) {
+      return lhs[i - 1] < rhs[i - 1] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+static Limb MulWordScalar(Limb* res, const Limb* lhs, size_t n, Limb mult,
+                          Limb carry) {
+  for (size_t i = 0; i < n; ++i) {
+    DoubleLimb cur = DoubleLimb(lhs[i]) * mult + carry;
+    res[i] = Limb(cur);
+    carry = Limb(cur >> kLimbBits);
+  }
+  return carry;
+}
+static Limb AddNScalar(Limb* res, const Limb* lhs, const Limb* rhs, size_t n) {
+  return AddNScalar(res, lhs, rhs, n, 0);
+}
+static Limb SubNScalar(Limb* res, const Limb* lhs, const Limb* rhs, size_t n) {
+  return SubNScalar(res, lhs, rhs, n, 0);
+}
+static Limb MulWordScalar(Limb* res, const Limb* lhs, size_t n, Limb mult) {
+  return MulWordScalar(res, lhs, n, mult, 0);
+}
+
+static void LanesAddScalar(Limb* res, const Limb* lhs, const Limb* rhs,
+                           Limb* carry, size_t n) {
+  for (size_t k = 0; k < n; ++k) {
+    DoubleLimb sum = DoubleLimb(lhs[k]) + rhs[k] + carry[k];
+    res[k] = Limb(sum);
+    carry[k] = Limb(sum >> kLimbBits);
+  }
+}
+static void LanesSubScalar(Limb* res, const Limb* lhs, const Limb* rhs,
+                           Limb* borrow, size_t n) {
+  for (size_t k = 0; k < n; ++k) {
+    Limb diff = lhs[k] - rhs[k];
+    Limb next_borrow = (lhs[k] < rhs[k] || diff < borrow[k]) ? 1 : 0;
+    res[k] = diff - borrow[k];
+    borrow[k] = next_borrow;
+  }
+}
+static void LanesMulAddScalar(Limb* res, Limb* carry, const Limb* lhs,
+                              const Limb* rhs, size_t n) {
+  for (size_t k = 0; k < n; ++k) {
+    DoubleLimb cur = DoubleLimb(lhs[k]) * rhs[k] + res[k] + carry[k];
+    res[k] = Limb(cur);
+    carry[k] = Limb(cur >> kLimbBits);
+  }
+}
+
+#ifdef LIMB_KERNELS_X86
+// a block adds lane by lane and then resolves all carries at once on the lane
+// masks: lanes that overflowed generate a carry, lanes equal to all ones pass
+// one on, the two sets are disjoint, so adding the generated carries shifted
+// by a lane to the passing lanes as integers ripples them through every run
+// of passing lanes, and xor with the passing lanes leaves the lanes that
+// receive a carry, bit `lanes` of the sum is the carry out of the block
+static unsigned IncomingCarries(unsigned generate, unsigned propagate,
+                                Limb& carry, size_t lanes) {
+  unsigned sum = (generate << 1) + unsigned(carry) + propagate;
+  carry = (sum >> lanes) & 1;
+  return (sum ^ propagate) & ((1u << lanes) - 1);
+}
+
+/* AVX2, four limbs per block */
+// lanes whose bit is set in mask become all ones
+__attribute__((target("avx2"))) static __m256i MaskToLanes(unsigned mask) {
+  const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+  return _mm256_cmpeq_epi64(
+      _mm256_and_si256(_mm256_set1_epi64x(mask), bits), bits);
+}
+// unsigned lhs < rhs on every lane as a four bit mask
+__attribute__((target("avx2"))) static unsigned LessMask(__m256i lhs,
+                                                         __m256i rhs) {
+  const __m256i flip = _mm256_set1_epi64x(int64_t(Limb(1) << 63));
+  __m256i less = _mm256_cmpgt_epi64(_mm256_xor_si256(rhs, flip),
+                                    _mm256_xor_si256(lhs, flip));
+  return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(less)));
+}
+__attribute__((target("avx2"))) static unsigned EqualMask(__m256i lhs,
+                                                          __m256i rhs) {
+  return unsigned(
+      _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(lhs, rhs))));
+}
+__attribute__((target("avx2"))) static Limb AddNAvx2(Limb* res,
+                                                     const Limb* lhs,
+                                                     const Limb* rhs,
+                                                     size_t n) {
+  const __m256i ones = _mm256_set1_epi64x(-1);
+  Limb carry = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i left = _mm256_loadu_si256((const __m256i*)(lhs + i));
+    __m256i right = _mm256_loadu_si256((const __m256i*)(rhs + i));
+    __m256i sum = _mm256_add_epi64(left, right);
+    unsigned incoming = IncomingCarries(LessMask(sum, left),
+                                        EqualMask(sum, ones), carry, 4);
+    sum = _mm256_sub_epi64(sum, MaskToLanes(incoming));
+    _mm256_storeu_si256((__m256i*)(res + i), sum);
+  }
+  return AddNScalar(res + i, lhs + i, rhs + i, n - i, carry);
+}
+// borrows are generated where lhs < rhs and pass through zero differences
+__attribute__((target("avx2"))) static Limb SubNAvx2(Limb* res,
+                                                     const Limb* lhs,
+                                                     const Limb* rhs,
+                                                     size_t n) {
+  const __m256i zero = _mm256_setzero_si256();
+  Limb borrow = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i left = _mm256_loadu_si256((const __m256i*)(lhs + i));
+    __m256i right = _mm256_loadu_si256((const __m256i*)(rhs + i));
+    __m256i diff = _mm256_sub_epi64(left, right);
+    unsigned incoming = IncomingCarries(LessMask(left, right),
+                                        EqualMask(diff, zero), borrow, 4);
+    diff = _mm256_add_epi64(diff, MaskToLanes(incoming));
+    _mm256_storeu_si256((__m256i*)(res + i), diff);
+  }
+  return SubNScalar(res + i, lhs + i, rhs + i, n - i, borrow);
+}
+// the lane kernels need the carry of every lane on its own, so the
+// comparisons stay vectors of all ones or zeros instead of bit masks
+__attribute__((target("avx2"))) static __m256i LessLanes(__m256i lhs,
+                                                         __m256i rhs) {
+  const __m256i flip = _mm256_set1_epi64x(int64_t(Limb(1) << 63));
+  return _mm256_cmpgt_epi64(_mm256_xor_si256(rhs, flip),
+                            _mm256_xor_si256(lhs, flip));
+}
+__attribute__((target("avx2"))) static void LanesAddAvx2(Limb* res,
+                                                         const Limb* lhs,
+                                                         const Limb* rhs,
+                                                         Limb* carry,
+                                                         size_t n) {
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    __m256i left = _mm256_loadu_si256((const __m256i*)(lhs + k));
+    __m256i right = _mm256_loadu_si256((const __m256i*)(rhs + k));
+    __m256i in = _mm256_loadu_si256((const __m256i*)(carry + k));
+    __m256i sum = _mm256_add_epi64(left, right);
+    __m256i out = LessLanes(sum, left);
+    __m256i total = _mm256_add_epi64(sum, in);
+    out = _mm256_or_si256(out, LessLanes(total, sum));
+    _mm256_storeu_si256((__m256i*)(res + k), total);
+    _mm256_storeu_si256((__m256i*)(carry + k), _mm256_srli_epi64(out, 63));
+  }
+  LanesAddScalar(res + k, lhs + k, rhs + k, carry + k, n - k);
+}
+__attribute__((target("avx2"))) static void LanesSubAvx2(Limb* res,
+                                                         const Limb* lhs,
+                                                         const Limb* rhs,
+                                                         Limb* borrow,
+                                                         size_t n) {
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    __m256i left = _mm256_loadu_si256((const __m256i*)(lhs + k));
+    __m256i right = _mm256_loadu_si256((const __m256i*)(rhs + k));
+    __m256i in = _mm256_loadu_si256((const __m256i*)(borrow + k));
+    __m256i diff = _mm256_sub_epi64(left, right);
+    __m256i out =
+        _mm256_or_si256(LessLanes(left, right), LessLanes(diff, in));
+    _mm256_storeu_si256((__m256i*)(res + k), _mm256_sub_epi64(diff, in));
+    _mm256_storeu_si256((__m256i*)(borrow + k), _mm256_srli_epi64(out, 63));
+  }
+  LanesSubScalar(res + k, lhs + k, rhs + k, borrow + k, n - k);
+}
+__attribute__((target("avx2"))) static int CompareNAvx2(const Limb* lhs,
+                                                        const Limb* rhs,
+                                                        size_t n) {
+  for (; n >= 4; n -= 4) {
+    __m256i left = _mm256_loadu_si256((const __m256i*)(lhs + n - 4));
+    __m256i right = _mm256_loadu_si256((const __m256i*)(rhs + n - 4));
+    unsigned differ = ~EqualMask(left, right) & 0xF;
+    if (differ != 0) {
+      size_t top = n - 4 + (31 - __builtin_clz(differ));
+      return lhs[top] < rhs[top] ? -1 : 1;
+    }
+  }
+  return CompareNScalar(lhs, rhs, n);
+}
+
+/* AVX-512, eight limbs per block */
+// GCC 12 reports the placeholder operand inside its own AVX-512 intrinsics as
+// uninitialized (GCC PR 105593)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+__attribute__((target("avx512f"))) static Limb AddNAvx512(Limb* res,
+                                                          const Limb* lhs,
+                                                          const Limb* rhs,
+                                                          size_t n) {
+  const __m512i ones = _mm512_set1_epi64(-1);
+  Limb carry = 0;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i left = _mm512_loadu_si512(lhs + i);
+    __m512i right = _mm512_loadu_si512(rhs + i);
+    __m512i sum = _mm512_add_epi64(left, right);
+    unsigned incoming =
+        IncomingCarries(_mm512_cmplt_epu64_mask(sum, left),
+                        _mm512_cmpeq_epi64_mask(sum, ones), carry, 8);
+    sum = _mm512_mask_sub_epi64(sum, __mmask8(incoming), sum, ones);
+    _mm512_storeu_si512(res + i, sum);
+  }
+  return AddNScalar(res + i, lhs + i, rhs + i, n - i, carry);
+}
+__attribute__((target("avx512f"))) static Limb SubNAvx512(Limb* res,
+                                                          const Limb* lhs,
+                                                          const Limb* rhs,
+                                                          size_t n) {
+  const __m512i ones = _mm512_set1_epi64(-1);
+  const __m512i zero = _mm512_setzero_si512();
+  Limb borrow = 0;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i left = _mm512_loadu_si512(lhs + i);
+    __m512i right = _mm512_loadu_si512(rhs + i);
+    __m512i diff = _mm512_sub_epi64(left, right);
+    unsigned incoming =
+        IncomingCarries(_mm512_cmplt_epu64_mask(left, right),
+                        _mm512_cmpeq_epi64_mask(diff, zero), borrow, 8);
+    diff = _mm512_mask_add_epi64(diff, __mmask8(incoming), diff, ones);
+    _mm512_storeu_si512(res + i, diff);
+  }
+  return SubNScalar(res + i, lhs + i, rhs + i, n - i, borrow);
+}
+__attribute__((target("avx512f"))) static int CompareNAvx512(const Limb* lhs,
+                                                             const Limb* rhs,
+                                                             size_t n) {
+  for (; n >= 8; n -= 8) {
+    __m512i left = _mm512_loadu_si512(lhs + n - 8);
+    __m512i right = _mm512_loadu_si512(rhs + n - 8);
+    unsigned differ = _mm512_cmpneq_epi64_mask(left, right);
+    if (differ != 0) {
+      size_t top = n - 8 + (31 - __builtin_clz(differ));
+      return lhs[top] < rhs[top] ? -1 : 1;
+    }
+  }
+  return CompareNScalar(lhs, rhs, n);
+}
+// the 128-bit products are assembled from four 32-bit ones per lane, the
+// high halves move up one lane and are added to the low halves with the
+// same carry resolution as AddNAvx512
+__attribute__((target("avx512f"))) static Limb MulWordAvx512(Limb* res,
+                                                             const Limb* lhs,
+                                                             size_t n,
+                                                             Limb mult) {
+  const __m512i ones = _mm512_set1_epi64(-1);
+  const __m512i low_mask = _mm512_set1_epi64(0xFFFFFFFF);
+  const __m512i mult_low = _mm512_set1_epi64(int64_t(mult));
+  const __m512i mult_high = _mm512_srli_epi64(mult_low, 32);
+  __m512i prev_high = _mm512_setzero_si512();
+  Limb carry = 0;
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i num = _mm512_loadu_si512(lhs + i);
+    __m512i num_high = _mm512_srli_epi64(num, 32);
+    __m512i low_low = _mm512_mul_epu32(num, mult_low);
+    __m512i low_high = _mm512_mul_epu32(num, mult_high);
+    __m512i high_low = _mm512_mul_epu32(num_high, mult_low);
+    __m512i high_high = _mm512_mul_epu32(num_high, mult_high);
+    __m512i mid = _mm512_add_epi64(
+        _mm512_srli_epi64(low_low, 32),
+        _mm512_add_epi64(_mm512_and_si512(low_high, low_mask),
+                         _mm512_and_si512(high_low, low_mask)));
+    __m512i low = _mm512_or_si512(_mm512_and_si512(low_low, low_mask),
+                                  _mm512_slli_epi64(mid, 32));
+    __m512i high = _mm512_add_epi64(
+        _mm512_add_epi64(high_high, _mm512_srli_epi64(mid, 32)),
+        _mm512_add_epi64(_mm512_srli_epi64(low_high, 32),
+                         _mm512_srli_epi64(high_low, 32)));
+    __m512i shifted = _mm512_alignr_epi64(high, prev_high, 7);
+    __m512i sum = _mm512_add_epi64(low, shifted);
+    unsigned incoming =
+        IncomingCarries(_mm512_cmplt_epu64_mask(sum, low),
+                        _mm512_cmpeq_epi64_mask(sum, ones), carry, 8);
+    sum = _mm512_mask_sub_epi64(sum, __mmask8(incoming), sum, ones);
+    _mm512_storeu_si512(res + i, sum);
+    prev_high = high;
+  }
+  // the top high half is at most 2^64 - 2, so the carry fits into it
+  alignas(64) Limb high_lanes[8];
+  _mm512_store_si512(high_lanes, prev_high);
+  return MulWordScalar(res + i, lhs + i, n - i, mult, high_lanes[7] + carry);
+}
+__attribute__((target("avx512f"))) static void LanesAddAvx512(
+    Limb* res, const Limb* lhs, const Limb* rhs, Limb* carry, size_t n) {
+  const __m512i one = _mm512_set1_epi64(1);
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m512i left = _mm512_loadu_si512(lhs + k);
+    __m512i sum = _mm512_add_epi64(left, _mm512_loadu_si512(rhs + k));
+    __m512i total = _mm512_add_epi64(sum, _mm512_loadu_si512(carry + k));
+    __mmask8 out = _mm512_cmplt_epu64_mask(sum, left) |
+                   _mm512_cmplt_epu64_mask(total, sum);
+    _mm512_storeu_si512(res + k, total);
+    _mm512_storeu_si512(carry + k, _mm512_maskz_mov_epi64(out, one));
+  }
+  LanesAddScalar(res + k, lhs + k, rhs + k, carry + k, n - k);
+}
+__attribute__((target("avx512f"))) static void LanesSubAvx512(
+    Limb* res, const Limb* lhs, const Limb* rhs, Limb* borrow, size_t n) {
+  const __m512i one = _mm512_set1_epi64(1);
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m512i left = _mm512_loadu_si512(lhs + k);
+    __m512i right = _mm512_loadu_si512(rhs + k);
+    __m512i in = _mm512_loadu_si512(borrow + k);
+    __m512i diff = _mm512_sub_epi64(left, right);
+    __mmask8 out = _mm512_cmplt_epu64_mask(left, right) |
+                   _mm512_cmplt_epu64_mask(diff, in);
+    _mm512_storeu_si512(res + k, _mm512_sub_epi64(diff, in));
+    _mm512_storeu_si512(borrow + k, _mm512_maskz_mov_epi64(out, one));
+  }
+  LanesSubScalar(res + k, lhs + k, rhs + k, borrow + k, n - k);
+}
+// each lane forms its 128-bit product from four 32-bit ones as in
+// MulWordAvx512, the two additions then carry into the high half, which
+// cannot overflow since the whole result fits two limbs
+__attribute__((target("avx512f"))) static void LanesMulAddAvx512(
+    Limb* res, Limb* carry, const Limb* lhs, const Limb* rhs, size_t n) {
+  const __m512i low_mask = _mm512_set1_epi64(0xFFFFFFFF);
+  const __m512i one = _mm512_set1_epi64(1);
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m512i left = _mm512_loadu_si512(lhs + k);
+    __m512i right = _mm512_loadu_si512(rhs + k);
+    __m512i left_high = _mm512_srli_epi64(left, 32);
+    __m512i right_high = _mm512_srli_epi64(right, 32);
+    __m512i low_low = _mm512_mul_epu32(left, right);
+    __m512i low_high = _mm512_mul_epu32(left, right_high);
+    __m512i high_low = _mm512_mul_epu32(left_high, right);
+    __m512i high_high = _mm512_mul_epu32(left_high, right_high);
+    __m512i mid = _mm512_add_epi64(
+        _mm512_srli_epi64(low_low, 32),
+        _mm512_add_epi64(_mm512_and_si512(low_high, low_mask),
+                         _mm512_and_si512(high_low, low_mask)));
+    __m512i low = _mm512_or_si512(_mm512_and_si512(low_low, low_mask),
+                                  _mm512_slli_epi64(mid, 32));
+    __m512i high = _mm512_add_epi64(
+        _mm512_add_epi64(high_high, _mm512_srli_epi64(mid, 32)),
+        _mm512_add_epi64(_mm512_srli_epi64(low_high, 32),
+                         _mm512_srli_epi64(high_low, 32)));
+    __m512i sum = _mm512_add_epi64(low, _mm512_loadu_si512(res + k));
+    high = _mm512_mask_add_epi64(high, _mm512_cmplt_epu64_mask(sum, low),
+                                 high, one);
+    __m512i total = _mm512_add_epi64(sum, _mm512_loadu_si512(carry + k));
+    high = _mm512_mask_add_epi64(high, _mm512_cmplt_epu64_mask(total, sum),
+                                 high, one);
+    _mm512_storeu_si512(res + k, total);
+    _mm512_storeu_si512(carry + k, high);
+  }
+  LanesMulAddScalar(res + k, carry + k, lhs + k, rhs + k, n - k);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+static const LimbKernels kScalarKernels = {
+    LimbIsa::kScalar, AddNScalar,     SubNScalar,     CompareNScalar,
+    MulWordScalar,    LanesAddScalar, LanesSubScalar, LanesMulAddScalar};
+#ifdef LIMB_KERNELS_X86
+// AVX2 multiplies only 32-bit halves, four of them per product lose to the
+// scalar 64-bit multiplier
+static const LimbKernels kAvx2Kernels = {
+    LimbIsa::kAvx2, AddNAvx2,     SubNAvx2,     CompareNAvx2,
+    MulWordScalar,  LanesAddAvx2, LanesSubAvx2, LanesMulAddScalar};
+static const LimbKernels kAvx512Kernels = {
+    LimbIsa::kAvx512, AddNAvx512,     SubNAvx512,     CompareNAvx512,
+    MulWordAvx512,    LanesAddAvx512, LanesSubAvx512, LanesMulAddAvx512};
+#endif
+
+static const LimbKernels& KernelsFor(LimbIsa isa) {
+#ifdef LIMB_KERNELS_X86
+  if (isa == LimbIsa::kAvx512) {
+    return kAvx512Kernels;
+  }
+  if (isa == LimbIsa::kAvx2) {
+    return kAvx2Kernels;
+  }
+#endif
+  (void)isa;
+  return kScalarKernels;
+}
+static const LimbKernels*& ActiveKernels() {
+  static const LimbKernels* kernels = &KernelsFor(BestLimbIsa());
+  return kernels;
+}
+LimbIsa BestLimbIsa() {
+#ifdef LIMB_KERNELS_X86
+  if (__builtin_cpu_supports("avx512f")) {
+    return LimbIsa::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return LimbIsa::kAvx2;
+  }
+#endif
+  return LimbIsa::kScalar;
+}
+LimbIsa ActiveLimbIsa() { return ActiveKernels()->isa; }
+void SelectLimbIsa(LimbIsa isa) {
+  if (int(isa) > int(BestLimbIsa())) {
+    isa = BestLimbIsa();
+  }
+  ActiveKernels() = &KernelsFor(isa);
+}
+uint64_t LimbAddN(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  size_t n) {
+  return ActiveKernels()->add_n(res, lhs, rhs, n);
+}
+uint64_t LimbSubN(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  size_t n) {
+  return ActiveKernels()->sub_n(res, lhs, rhs, n);
+}
+int LimbCompareN(const uint64_t* lhs, const uint64_t* rhs, size_t n) {
+  return ActiveKernels()->compare_n(lhs, rhs, n);
+}
+uint64_t LimbMulWord(uint64_t* res, const uint64_t* lhs, size_t n,
+                     uint64_t mult) {
+  return ActiveKernels()->mul_word(res, lhs, n, mult);
+}
+void LimbLanesAdd(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  uint64_t* carry, size_t n) {
+  ActiveKernels()->lanes_add(res, lhs, rhs, carry, n);
+}
+void LimbLanesSub(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  uint64_t* borrow, size_t n) {
+  ActiveKernels()->lanes_sub(res, lhs, rhs, borrow, n);
+}
+void LimbLanesMulAdd(uint64_t* res, uint64_t* carry, const uint64_t* lhs,
+                     const uint64_t* rhs, size_t n) {
+  ActiveKernels()->lanes_mul_add(res, carry, lhs, rhs, n);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+// span kernels on little-endian 64-bit limbs, the result may alias the
+// operands, every call goes to the widest implementation the CPU supports
+enum class LimbIsa { kScalar, kAvx2, kAvx512 };
+LimbIsa BestLimbIsa();
+LimbIsa ActiveLimbIsa();
+// switches all kernels, isa is clamped to BestLimbIsa(), not thread safe
+void SelectLimbIsa(LimbIsa isa);
+
+// res[0..n) = lhs + rhs, returns the carry out
+uint64_t LimbAddN(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  size_t n);
+// res[0..n) = lhs - rhs, returns the borrow out
+uint64_t LimbSubN(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  size_t n);
+// sign of lhs - rhs for two n-limb numbers
+int LimbCompareN(const uint64_t* lhs, const uint64_t* rhs, size_t n);
+// res[0..n) = lhs * mult, returns the high limb
+uint64_t LimbMulWord(uint64_t* res, const uint64_t* lhs, size_t n,
+                     uint64_t mult);
+
+// lane kernels run one step on n independent numbers at once, lane k of
+// every span belongs to the k-th number and carries are 0 or 1
+// res[k] = lhs[k] + rhs[k] + carry[k], carry[k] becomes the carry out
+void LimbLanesAdd(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  uint64_t* carry, size_t n);
+// res[k] = lhs[k] - rhs[k] - borrow[k], borrow[k] becomes the borrow out
+void LimbLanesSub(uint64_t* res, const uint64_t* lhs, const uint64_t* rhs,
+                  uint64_t* borrow, size_t n);
+// the two limbs of res[k] + lhs[k] * rhs[k] + carry[k] go to res[k] and
+// carry[k], here the carry is a whole limb
+void LimbLanesMulAdd(uint64_t* res, uint64_t* carry, const uint64_t* lhs,
+                     const uint64_t* rhs, size_t n);
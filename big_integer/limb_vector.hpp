@@ -0,0 +1,155 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+// vector of 64-bit limbs keeping up to kInlineLimbs of them inside the object,
+// the heap is used only after the first growth past that
+class LimbVector {
+ public:
+  using Limb = uint64_t;
+  using value_type = Limb;
+  using iterator = Limb*;
+  using const_iterator = const Limb*;
+  static constexpr size_t kInlineLimbs = 2;
+
+  LimbVector() = default;
+  explicit LimbVector(size_t size, Limb value = 0) { assign(size, value); }
+  LimbVector(const Limb* first, const Limb* last) { assign(first, last); }
+  LimbVector(std::initializer_list<Limb> list) {
+    assign(list.begin(), list.end());
+  }
+  LimbVector(const LimbVector& other) { assign(other.begin(), other.end()); }
+  LimbVector(LimbVector&& other) noexcept { Steal(other); }
+  LimbVector& operator=(const LimbVector& other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+  LimbVector& operator=(LimbVector&& other) noexcept {
+    if (this != &other) {
+      Release();
+      Steal(other);
+    }
+    return *this;
+  }
+  ~LimbVector() { Release(); }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+  Limb* data() { return data_; }
+  const Limb* data() const { return data_; }
+  Limb* begin() { return data_; }
+  const Limb* begin() const { return data_; }
+  Limb* end() { return data_ + size_; }
+  const Limb* end() const { return data_ + size_; }
+  Limb& operator[](size_t i) { return data_[i]; }
+  const Limb& operator[](size_t i) const { return data_[i]; }
+  Limb& back() { return data_[size_ - 1]; }
+  const Limb& back() const { return data_[size_ - 1]; }
+
+  void reserve(size_t capacity) {
+    if (capacity <= capacity_) {
+      return;
+    }
+    Limb* data = new Limb[capacity];
+    std::memcpy(data, data_, size_ * sizeof(Limb));
+    Release();
+    data_ = data;
+    capacity_ = capacity;
+  }
+  void clear() { size_ = 0; }
+  void resize(size_t size, Limb value = 0) {
+    if (size > size_) {
+      Grow(size);
+      std::fill(data_ + size_, data_ + size, value);
+    }
+    size_ = size;
+  }
+  void push_back(Limb value) {
+    Grow(size_ + 1);
+    data_[size_++] = value;
+  }
+  void pop_back() { --size_; }
+  void assign(size_t size, Limb value) {
+    size_ = 0;
+    resize(size, value);
+  }
+  void assign(const Limb* first, const Limb* last) {
+    size_t size = last - first;
+    size_ = 0;
+    Grow(size);
+    std::copy(first, last, data_);
+    size_ = size;
+  }
+  Limb* insert(const Limb* pos, size_t count, Limb value) {
+    size_t index = OpenGap(pos, count);
+    std::fill(data_ + index, data_ + index + count, value);
+    return data_ + index;
+  }
+  // the range must not come from this vector
+  Limb* insert(const Limb* pos, const Limb* first, const Limb* last) {
+    size_t count = last - first;
+    size_t index = OpenGap(pos, count);
+    std::copy(first, last, data_ + index);
+    return data_ + index;
+  }
+  Limb* erase(const Limb* first, const Limb* last) {
+    size_t index = first - data_;
+    size_t count = last - first;
+    std::memmove(data_ + index, data_ + index + count,
+                 (size_ - index - count) * sizeof(Limb));
+    size_ -= count;
+    return data_ + index;
+  }
+
+  bool operator==(const LimbVector& other) const {
+    return size_ == other.size_ &&
+           std::equal(data_, data_ + size_, other.data_);
+  }
+  bool operator!=(const LimbVector& other) const { return !(*this == other); }
+
+ private:
+  bool IsInline() const { return data_ == inline_; }
+  void Grow(size_t size) {
+    if (size > capacity_) {
+      reserve(std::max(size, 2 * capacity_));
+    }
+  }
+  size_t OpenGap(const Limb* pos, size_t count) {
+    size_t index = pos - data_;
+    Grow(size_ + count);
+    std::memmove(data_ + index + count, data_ + index,
+                 (size_ - index) * sizeof(Limb));
+    size_ += count;
+    return index;
+  }
+  void Release() {
+    if (!IsInline()) {
+      delete[] data_;
+    }
+    data_ = inline_;
+    capacity_ = kInlineLimbs;
+  }
+  // other must not own a heap buffer of *this
+  void Steal(LimbVector& other) {
+    size_ = other.size_;
+    if (other.IsInline()) {
+      std::memcpy(inline_, other.inline_, size_ * sizeof(Limb));
+    } else {
+      data_ = other.data_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_;
+      other.capacity_ = kInlineLimbs;
+    }
+    other.size_ = 0;
+  }
+
+  Limb inline_[kInlineLimbs];
+  Limb* data_ = inline_;
+  size_t size_ = 0;
+  size_t capacity_ = kInlineLimbs;
+};
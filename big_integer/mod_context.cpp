@@ -0,0 +1,297 @@
+#include "mod_context.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "limb_kernels.hpp"
+
+using Limb = BigInt::Limb;
+__extension__ using DoubleLimb = unsigned __int128;
+
+static const size_t kLimbBits = 64;
+
+static bool TestBit(const LimbVector& number, size_t bit) {
+  return ((number[bit / kLimbBits] >> (bit % kLimbBits)) & 1) != 0;
+}
+static size_t BitLength(const LimbVector& number) {
+  if (number.empty()) {
+    return 0;
+  }
+  return (number.size() - 1) * kLimbBits + std::bit_width(number.back());
+}
+// number of exponent bits covered by one table lookup
+static size_t WindowSize(size_t bits) {
+  if (bits > 671) {
+    return 6;
+  }
+  if (bits > 239) {
+    return 5;
+  }
+  if (bits > 79) {
+    return 4;
+  }
+  return bits > 23 ? 3 : 1;
+}
+// base^exp for exp > 0, windows of up to w bits ending in a one are looked
+// up among the odd powers base^1, base^3, ..., base^(2^w - 1)
+template <typename Value, typename MulFn>
+static Value SlidingPow(const Value& base, const LimbVector& exp, MulFn mul) {
+  size_t bits = BitLength(exp);
+  size_t window = WindowSize(bits);
+  std::vector<Value> table(size_t(1) << (window - 1), base);
+  if (table.size() > 1) {
+    Value square = base;
+    mul(square, base, base);
+    for (size_t i = 1; i < table.size(); ++i) {
+      mul(table[i], table[i - 1], square);
+    }
+  }
+  Value result = base;
+  bool started = false;
+  for (size_t i = bits; i > 0;) {
+    if (!TestBit(exp, i - 1)) {
+      mul(result, result, result);
+      --i;
+      continue;
+    }
+    size_t low = i > window ? i - window : 0;
+    while (!TestBit(exp, low)) {
+      ++low;
+    }
+    size_t index = 0;
+    for (size_t bit = i; bit > low; --bit) {
+      index = 2 * index + (TestBit(exp, bit - 1) ? 1 : 0);
+    }
+    if (started) {
+      for (size_t k = low; k < i; ++k) {
+        mul(result, result, result);
+      }
+      mul(result, result, table[index / 2]);
+    } else {
+      result = table[index / 2];
+      started = true;
+    }
+    i = low;
+  }
+  return result;
+}
+
+ModContext::ModContext(const BigInt& modulus, Reduction reduction)
+    : modulus_(modulus < BigInt(0) ? -modulus : modulus),
+      reduction_(reduction) {
+  size_ = modulus_.number_.size();
+  if (modulus_.number_.empty() || (modulus_.number_[0] & 1) == 0) {
+    reduction_ = Reduction::kBarrett;
+  }
+  if (reduction_ == Reduction::kBarrett) {
+    std::vector<Limb> power(2 * size_ + 1, 0);
+    power.back() = 1;
+    barrett_mu_ = BigInt(power) / modulus_;
+    return;
+  }
+  // Newton's iteration doubles the correct low bits of m^(-1) starting
+  // from the three given by m * m == 1 mod 8
+  Limb low = modulus_.number_[0];
+  Limb inverse = low;
+  for (int i = 0; i < 5; ++i) {
+    inverse *= 2 - low * inverse;
+  }
+  mont_inverse_ = Limb(0) - inverse;
+  std::vector<Limb> power(2 * size_ + 1, 0);
+  power.back() = 1;
+  mont_r2_ = (BigInt(power) % modulus_).number_;
+  mont_r2_.resize(size_);
+}
+const BigInt& ModContext::Modulus() const { return modulus_; }
+ModContext::Reduction ModContext::GetReduction() const { return reduction_; }
+BigInt ModContext::Reduce(const BigInt& num) const {
+  if (modulus_ <= BigInt(1)) {
+    return BigInt();
+  }
+  if (num.sign_ && num < modulus_) {
+    return num;
+  }
+  if (num.sign_ && num.number_.size() <= 2 * size_ &&
+      reduction_ == Reduction::kBarrett) {
+    return BarrettReduce(num);
+  }
+  BigInt rem = num % modulus_;
+  if (!rem.sign_) {
+    rem += modulus_;
+  }
+  return rem;
+}
+BigInt ModContext::BarrettReduce(const BigInt& num) const {
+  BigInt quot = num;
+  quot.ShiftRight(size_ - 1);
+  quot *= barrett_mu_;
+  quot.ShiftRight(size_ + 1);
+  BigInt rem = num - quot * modulus_;
+  while (rem >= modulus_) {
+    rem -= modulus_;
+  }
+  return rem;
+}
+BigInt ModContext::BarrettMul(const BigInt& lhs, const BigInt& rhs) const {
+  return BarrettReduce(lhs * rhs);
+}
+// coarsely integrated operand scanning, scratch holds n + 2 limbs and the
+// result stays below 2m before the final subtraction
+void ModContext::MontMul(Limb* res, const Limb* lhs, const Limb* rhs,
+                         Limb* scratch) const {
+  size_t n = size_;
+  const Limb* mod = modulus_.number_.data();
+  std::fill(scratch, scratch + n + 2, 0);
+  for (size_t i = 0; i < n; ++i) {
+    Limb carry = 0;
+    Limb digit = rhs[i];
+    for (size_t j = 0; j < n; ++j) {
+      DoubleLimb cur = DoubleLimb(lhs[j]) * digit + scratch[j] + carry;
+      scratch[j] = Limb(cur);
+      carry = Limb(cur >> kLimbBits);
+    }
+    DoubleLimb top = DoubleLimb(scratch[n]) + carry;
+    scratch[n] = Limb(top);
+    scratch[n + 1] = Limb(top >> kLimbBits);
+    Limb mult = scratch[0] * mont_inverse_;
+    DoubleLimb cur = DoubleLimb(mod[0]) * mult + scratch[0];
+    carry = Limb(cur >> kLimbBits);
+    for (size_t j = 1; j < n; ++j) {
+      cur = DoubleLimb(mod[j]) * mult + scratch[j] + carry;
+      scratch[j - 1] = Limb(cur);
+      carry = Limb(cur >> kLimbBits);
+    }
+    top = DoubleLimb(scratch[n]) + carry;
+    scratch[n - 1] = Limb(top);
+    scratch[n] = scratch[n + 1] + Limb(top >> kLimbBits);
+  }
+  bool subtract = scratch[n] != 0 || LimbCompareN(scratch, mod, n) >= 0;
+  Limb borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    Limb sub = subtract ? mod[i] : 0;
+    Limb diff = scratch[i] - sub;
+    Limb next_borrow = (scratch[i] < sub || diff < borrow) ? 1 : 0;
+    res[i] = diff - borrow;
+    borrow = next_borrow;
+  }
+}
+// the square of an n-limb value is summed as twice the products above the
+// diagonal plus the diagonal, then divided by R one limb at a time while
+// the pending carry rides one limb ahead, scratch holds 2n + 2 limbs
+void ModContext::MontSqr(Limb* res, const Limb* num, Limb* scratch) const {
+  size_t n = size_;
+  const Limb* mod = modulus_.number_.data();
+  std::fill(scratch, scratch + 2 * n + 2, 0);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    Limb carry = 0;
+    Limb digit = num[i];
+    for (size_t j = i + 1; j < n; ++j) {
+      DoubleLimb cur = DoubleLimb(num[j]) * digit + scratch[i + j] + carry;
+      scratch[i + j] = Limb(cur);
+      carry = Limb(cur >> kLimbBits);
+    }
+    scratch[i + n] = carry;
+  }
+  Limb shifted = 0;
+  for (size_t i = 0; i < 2 * n; ++i) {
+    Limb next = scratch[i] >> (kLimbBits - 1);
+    scratch[i] = (scratch[i] << 1) | shifted;
+    shifted = next;
+  }
+  Limb carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    DoubleLimb square = DoubleLimb(num[i]) * num[i];
+    DoubleLimb cur = DoubleLimb(scratch[2 * i]) + Limb(square) + carry;
+    scratch[2 * i] = Limb(cur);
+    cur = DoubleLimb(scratch[2 * i + 1]) + Limb(square >> kLimbBits) +
+          Limb(cur >> kLimbBits);
+    scratch[2 * i + 1] = Limb(cur);
+    carry = Limb(cur >> kLimbBits);
+  }
+  Limb pending = 0;
+  for (size_t i = 0; i < n; ++i) {
+    Limb mult = scratch[i] * mont_inverse_;
+    carry = 0;
+    for (size_t j = 0; j < n; ++j) {
+      DoubleLimb cur = DoubleLimb(mod[j]) * mult + scratch[i + j] + carry;
+      scratch[i + j] = Limb(cur);
+      carry = Limb(cur >> kLimbBits);
+    }
+    DoubleLimb cur = DoubleLimb(scratch[i + n]) + carry + pending;
+    scratch[i + n] = Limb(cur);
+    pending = Limb(cur >> kLimbBits);
+  }
+  Limb* high = scratch + n;
+  bool subtract = pending != 0 || LimbCompareN(high, mod, n) >= 0;
+  Limb borrow = 0;
+  for (size_t i = 0; i < n; ++i) {
+    Limb sub = subtract ? mod[i] : 0;
+    Limb diff = high[i] - sub;
+    Limb next_borrow = (high[i] < sub || diff < borrow) ? 1 : 0;
+    res[i] = diff - borrow;
+    borrow = next_borrow;
+  }
+}
+LimbVector ModContext::ToMontgomery(const BigInt& num, Limb* scratch) const {
+  LimbVector result(size_);
+  std::copy(num.number_.begin(), num.number_.end(), result.begin());
+  MontMul(result.data(), result.data(), mont_r2_.data(), scratch);
+  return result;
+}
+BigInt ModContext::FromMontgomery(const LimbVector& num, Limb* scratch) const {
+  LimbVector one(size_);
+  one[0] = 1;
+  LimbVector result(size_);
+  MontMul(result.data(), num.data(), one.data(), scratch);
+  return BigInt(true, std::move(result));
+}
+BigInt ModContext::MulMod(const BigInt& lhs, const BigInt& rhs) const {
+  if (modulus_ <= BigInt(1)) {
+    return BigInt();
+  }
+  BigInt left = Reduce(lhs);
+  BigInt right = Reduce(rhs);
+  if (reduction_ == Reduction::kBarrett) {
+    return BarrettMul(left, right);
+  }
+  // lhs * rhs / R is brought back by one more product with R^2
+  LimbVector scratch(size_ + 2);
+  LimbVector product(size_);
+  LimbVector left_limbs(size_);
+  LimbVector right_limbs(size_);
+  std::copy(left.number_.begin(), left.number_.end(), left_limbs.begin());
+  std::copy(right.number_.begin(), right.number_.end(), right_limbs.begin());
+  MontMul(product.data(), left_limbs.data(), right_limbs.data(),
+          scratch.data());
+  MontMul(product.data(), product.data(), mont_r2_.data(), scratch.data());
+  return BigInt(true, std::move(product));
+}
+BigInt ModContext::PowMont(const BigInt& base, const BigInt& exp) const {
+  LimbVector scratch(2 * size_ + 2);
+  LimbVector power = SlidingPow(
+      ToMontgomery(base, scratch.data()), exp.number_,
+      [&](LimbVector& res, const LimbVector& lhs, const LimbVector& rhs) {
+        if (&lhs == &rhs) {
+          MontSqr(res.data(), lhs.data(), scratch.data());
+        } else {
+          MontMul(res.data(), lhs.data(), rhs.data(), scratch.data());
+        }
+      });
+  return FromMontgomery(power, scratch.data());
+}
+BigInt ModContext::PowMod(const BigInt& base, const BigInt& exp) const {
+  if (modulus_ <= BigInt(1)) {
+    return BigInt();
+  }
+  if (exp.number_.empty()) {
+    return BigInt(1);
+  }
+  BigInt reduced = Reduce(base);
+  if (reduction_ == Reduction::kMontgomery) {
+    return PowMont(reduced, exp);
+  }
+  return SlidingPow(reduced, exp.number_,
+                    [&](BigInt& res, const BigInt& lhs, const BigInt& rhs) {
+                      res = BarrettMul(lhs, rhs);
+                    });
+}
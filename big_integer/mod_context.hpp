@@ -0,0 +1,40 @@
+#pragma once
+#include "big_integer.hpp"
+// arithmetic modulo a fixed modulus with the reduction constants computed
+// once, results are always in [0, modulus)
+class ModContext {
+ public:
+  enum class Reduction { kMontgomery, kBarrett };
+  // Montgomery needs an odd modulus, even moduli always use Barrett, a
+  // modulus is taken by absolute value and everything is zero modulo 0 or 1
+  explicit ModContext(const BigInt& modulus,
+                      Reduction reduction = Reduction::kMontgomery);
+  const BigInt& Modulus() const;
+  Reduction GetReduction() const;
+  BigInt Reduce(const BigInt& num) const;
+  BigInt MulMod(const BigInt& lhs, const BigInt& rhs) const;
+  // the sign of exp is ignored
+  BigInt PowMod(const BigInt& base, const BigInt& exp) const;
+
+ private:
+  using Limb = BigInt::Limb;
+  // num mod m for 0 <= num < B^(2n), at most two subtractions are left
+  BigInt BarrettReduce(const BigInt& num) const;
+  BigInt BarrettMul(const BigInt& lhs, const BigInt& rhs) const;
+  // res = lhs * rhs / R mod m on n-limb values, res may alias the operands
+  void MontMul(Limb* res, const Limb* lhs, const Limb* rhs,
+               Limb* scratch) const;
+  void MontSqr(Limb* res, const Limb* num, Limb* scratch) const;
+  LimbVector ToMontgomery(const BigInt& num, Limb* scratch) const;
+  BigInt FromMontgomery(const LimbVector& num, Limb* scratch) const;
+  BigInt PowMont(const BigInt& base, const BigInt& exp) const;
+
+  BigInt modulus_;
+  Reduction reduction_;
+  size_t size_ = 0;
+  // floor(B^(2n) / m) for Barrett
+  BigInt barrett_mu_;
+  // -m^(-1) mod B and R^2 mod m with R = B^n for Montgomery
+  Limb mont_inverse_ = 0;
+  LimbVector mont_r2_;
+};
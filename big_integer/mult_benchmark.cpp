@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_integer.hpp"
+
+/* Sweeps operand sizes and times operator* with the algorithm ladder cut at
+   every rung, so the crossover points of BigInt::mul_thresholds can be read
+   off the table. Usage: big_integer_mult_benchmark [max_limbs [karatsuba
+   toom3 ntt]], the optional thresholds replace the defaults for all rows. */
+
+struct Ladder {
+  const char* name;
+  BigInt::MulThresholds thresholds;
+  size_t max_limbs;
+};
+
+static constexpr size_t kDefaultMaxLimbs = 1 << 17;
+static constexpr size_t kMinLimbs = 8;
+static constexpr size_t kNever = std::numeric_limits<size_t>::max();
+static constexpr double kMinDurationMs = 50;
+static constexpr double kDigitsPerLimb = 19.27;
+
+static BigInt RandomNumber(size_t limbs, std::mt19937_64& gen) {
+  std::vector<BigInt::Limb> number(limbs);
+  std::generate(number.begin(), number.end(), gen);
+  number.back() |= 1;
+  return BigInt(number);
+}
+
+static double MeasureMs(const BigInt& lhs, const BigInt& rhs) {
+  size_t runs = 0;
+  double elapsed = 0;
+  while (elapsed < kMinDurationMs) {
+    auto start = std::chrono::steady_clock::now();
+    BigInt product = lhs * rhs;
+    auto stop = std::chrono::steady_clock::now();
+    elapsed += std::chrono::duration<double, std::milli>(stop - start).count();
+    ++runs;
+  }
+  return elapsed / runs;
+}
+
+int main(int argc, char** argv) {
+  size_t max_limbs = argc > 1 ? std::stoul(argv[1]) : kDefaultMaxLimbs;
+  BigInt::MulThresholds tuned = BigInt::mul_thresholds;
+  if (argc > 4) {
+    tuned = {std::stoul(argv[2]), std::stoul(argv[3]), std::stoul(argv[4])};
+  }
+  const std::vector<Ladder> kLadders = {
+      {"schoolbook", {kNever, kNever, kNever}, 1 << 12},
+      {"karatsuba", {tuned.karatsuba, kNever, kNever}, 1 << 16},
+      {"toom3", {tuned.karatsuba, tuned.toom3, kNever}, 1 << 17},
+      {"ntt", {tuned.karatsuba, tuned.toom3, tuned.karatsuba}, kNever},
+      {"auto", tuned, kNever},
+  };
+  std::cout << std::setw(10) << "limbs" << std::setw(12) << "digits";
+  for (const Ladder& ladder : kLadders) {
+    std::cout << std::setw(14) << ladder.name;
+  }
+  std::cout << "   (ms per product)" << std::endl;
+
+  std::mt19937_64 gen(kMinLimbs);
+  for (size_t limbs = kMinLimbs; limbs <= max_limbs; limbs += limbs / 2) {
+    BigInt lhs = RandomNumber(limbs, gen);
+    BigInt rhs = RandomNumber(limbs, gen);
+    std::cout << std::setw(10) << limbs << std::setw(12)
+              << size_t(limbs * kDigitsPerLimb);
+    for (const Ladder& ladder : kLadders) {
+      std::cout << std::setw(14);
+      if (limbs > ladder.max_limbs) {
+        std::cout << "-";
+        continue;
+      }
+      BigInt::mul_thresholds = ladder.thresholds;
+      std::cout << std::fixed << std::setprecision(4) << MeasureMs(lhs, rhs);
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
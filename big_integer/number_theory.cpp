@@ -0,0 +1,588 @@
+#include "number_theory.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include "mod_context.hpp"
+
+using Limb = BigInt::Limb;
+
+static const size_t kLimbBits = 64;
+// leading bits seen by one Lehmer step, the cofactor sums of Knuth's
+// algorithm L then stay inside int64_t
+static const size_t kLehmerBits = 62;
+// values below 2^52 are exact doubles
+static const size_t kExactDoubleBits = 52;
+static const Limb kSmallPrimeLimit = 1000;
+// 20! is the largest factorial of one limb
+static const size_t kLimbFactorial = 20;
+// binomials with k below n / kDirectBinomialRatio divide the product of the
+// top k factors by k! rather than sieve up to n
+static const size_t kDirectBinomialRatio = 16;
+
+static BigInt FromLimb(Limb value) {
+  return BigInt(std::vector<Limb>{value});
+}
+static BigInt Abs(const BigInt& num) { return num < BigInt(0) ? -num : num; }
+
+/* greatest common divisor */
+// matrix of the Euclidean steps that the leading bits of a >= b decide on
+// their own, b == 0 when not even the first quotient is certain
+struct Cofactors {
+  int64_t a;
+  int64_t b;
+  int64_t c;
+  int64_t d;
+};
+static Cofactors LehmerCofactors(const BigInt& a, const BigInt& b) {
+  size_t bits = a.BitLength();
+  size_t shift = bits > kLehmerBits ? bits - kLehmerBits : 0;
+  int64_t x = int64_t((a >> shift).ToInt());
+  int64_t y = int64_t((b >> shift).ToInt());
+  Cofactors m = {1, 0, 0, 1};
+  while (y + m.c != 0 && y + m.d != 0) {
+    int64_t q = (x + m.a) / (y + m.c);
+    if (q != (x + m.b) / (y + m.d)) {
+      break;
+    }
+    int64_t t = m.a - q * m.c;
+    m.a = m.c;
+    m.c = t;
+    t = m.b - q * m.d;
+    m.b = m.d;
+    m.d = t;
+    t = x - q * y;
+    x = y;
+    y = t;
+  }
+  return m;
+}
+// (lhs, rhs) = (a * lhs + b * rhs, c * lhs + d * rhs), each in one pass
+static void ApplyCofactors(const Cofactors& m, BigInt& lhs, BigInt& rhs) {
+  BigInt next = Lazy(lhs) * m.a + Lazy(rhs) * m.b;
+  rhs = Lazy(lhs) * m.c + Lazy(rhs) * m.d;
+  lhs = std::move(next);
+}
+BigInt Gcd(const BigInt& lhs, const BigInt& rhs) {
+  BigInt a = Abs(lhs);
+  BigInt b = Abs(rhs);
+  if (a < b) {
+    std::swap(a, b);
+  }
+  while (b.BitLength() > kLimbBits) {
+    Cofactors m = LehmerCofactors(a, b);
+    if (m.b == 0) {
+      BigInt rem = a % b;
+      a = std::move(b);
+      b = std::move(rem);
+    } else {
+      ApplyCofactors(m, a, b);
+    }
+  }
+  if (b == BigInt(0)) {
+    return a;
+  }
+  return FromLimb(std::gcd(Limb(b.ToInt()), Limb((a % b).ToInt())));
+}
+// the cofactor of the larger operand follows the same steps as the
+// remainders, the other one comes from a single division at the end
+BigInt ExtendedGcd(const BigInt& lhs, const BigInt& rhs, BigInt& x,
+                   BigInt& y) {
+  bool swapped = Abs(lhs) < Abs(rhs);
+  const BigInt& first = swapped ? rhs : lhs;
+  const BigInt& second = swapped ? lhs : rhs;
+  BigInt a = Abs(first);
+  BigInt b = Abs(second);
+  BigInt a_coef(1);
+  BigInt b_coef(0);
+  while (b != BigInt(0)) {
+    Cofactors m = LehmerCofactors(a, b);
+    if (m.b == 0) {
+      std::pair<BigInt, BigInt> division = a.DivMod(b);
+      a = std::move(b);
+      b = std::move(division.second);
+      BigInt next = a_coef - division.first * b_coef;
+      a_coef = std::move(b_coef);
+      b_coef = std::move(next);
+    } else {
+      ApplyCofactors(m, a, b);
+      ApplyCofactors(m, a_coef, b_coef);
+    }
+  }
+  BigInt first_coef = first < BigInt(0) ? -a_coef : a_coef;
+  BigInt second_coef;
+  if (second != BigInt(0)) {
+    second_coef = (a - first * first_coef) / second;
+  }
+  x = swapped ? second_coef : first_coef;
+  y = swapped ? first_coef : second_coef;
+  return a;
+}
+
+/* integer roots */
+static BigInt Pow(const BigInt& base, size_t exp) {
+  BigInt result(1);
+  BigInt square = base;
+  for (; exp != 0; exp >>= 1) {
+    if ((exp & 1) != 0) {
+      result *= square;
+    }
+    if (exp > 1) {
+      square *= square;
+    }
+  }
+  return result;
+}
+// the root of the top half of the bits, scaled back, is one Newton step
+// away from floor(sqrt(num)) up to a unit or two
+BigInt ISqrt(const BigInt& num) {
+  if (num < BigInt(1)) {
+    return BigInt();
+  }
+  size_t bits = num.BitLength();
+  if (bits <= kExactDoubleBits) {
+    Limb value = num.ToInt();
+    Limb root = Limb(std::sqrt(double(value)));
+    while (root * root > value) {
+      --root;
+    }
+    while ((root + 1) * (root + 1) <= value) {
+      ++root;
+    }
+    return FromLimb(root);
+  }
+  size_t shift = bits / 4;
+  BigInt root = ISqrt(num >> (2 * shift)) << shift;
+  root = (root + num / root) >> 1;
+  // (r -+ 1)^2 = r^2 -+ 2r + 1
+  BigInt square = root * root;
+  while (square > num) {
+    square -= (root << 1) - BigInt(1);
+    --root;
+  }
+  for (BigInt next = square + (root << 1) + BigInt(1); next <= num;
+       next += (root << 1) + BigInt(1)) {
+    ++root;
+  }
+  return root;
+}
+// moves an estimate a few units off to floor(num^(1/k))
+static BigInt CorrectRoot(BigInt root, const BigInt& num, size_t k) {
+  while (Pow(root, k) > num) {
+    --root;
+  }
+  while (Pow(root + BigInt(1), k) <= num) {
+    ++root;
+  }
+  return root;
+}
+// x = ((k - 1) x + num / x^(k - 1)) / k
+static BigInt NewtonRootStep(const BigInt& root, const BigInt& num, size_t k) {
+  return (root * BigInt(int64_t(k - 1)) + num / Pow(root, k - 1)) /
+         BigInt(int64_t(k));
+}
+// root below 2^64: the floating point estimate is pushed above the root,
+// from where the Newton iteration decreases until it stops at the floor
+static BigInt IRootSmall(const BigInt& num, size_t k) {
+  size_t bits = num.BitLength();
+  size_t shift = bits > kExactDoubleBits ? bits - kExactDoubleBits : 0;
+  double log = double(shift) + std::log2(double((num >> shift).ToInt()));
+  double estimate = std::exp2(log / double(k)) * (1 + 1e-9) + 2;
+  BigInt root = estimate >= 0x1p64 ? BigInt(1) << kLimbBits
+                                   : FromLimb(Limb(estimate));
+  for (BigInt next = NewtonRootStep(root, num, k); next < root;
+       next = NewtonRootStep(root, num, k)) {
+    root = std::move(next);
+  }
+  return CorrectRoot(std::move(root), num, k);
+}
+// one Newton step squares the relative error 2^shift / root of the scaled
+// root of the top bits and multiplies it by about (k - 1) / 2 * root, the
+// shift keeps bit_width(k) + 1 bits of margin below half the root length
+BigInt IRoot(const BigInt& num, size_t k) {
+  if (k == 0) {
+    return BigInt();
+  }
+  if (num < BigInt(0)) {
+    return (k % 2 == 1) ? -IRoot(-num, k) : BigInt();
+  }
+  if (k == 1 || num < BigInt(2)) {
+    return num;
+  }
+  if (k == 2) {
+    return ISqrt(num);
+  }
+  size_t bits = num.BitLength();
+  if (bits <= k) {
+    return BigInt(1);
+  }
+  size_t root_bits = bits / k;
+  size_t margin = std::bit_width(k) + 1;
+  if (root_bits < kLimbBits) {
+    return IRootSmall(num, k);
+  }
+  size_t shift = (root_bits - margin) / 2;
+  BigInt root = IRoot(num >> (k * shift), k) << shift;
+  return CorrectRoot(NewtonRootStep(root, num, k), num, k);
+}
+
+/* primality */
+// odd primes below kSmallPrimeLimit grouped so that the product of every
+// group fits an int64_t, one division by the product serves the group
+static const std::vector<std::vector<Limb>>& SmallPrimeGroups() {
+  static const std::vector<std::vector<Limb>> groups = [] {
+    std::vector<std::vector<Limb>> result;
+    std::vector<bool> composite(kSmallPrimeLimit, false);
+    Limb product = 1;
+    for (Limb p = 3; p < kSmallPrimeLimit; p += 2) {
+      if (composite[p]) {
+        continue;
+      }
+      for (Limb multiple = p * p; multiple < kSmallPrimeLimit;
+           multiple += 2 * p) {
+        composite[multiple] = true;
+      }
+      if (result.empty() || product > Limb(INT64_MAX) / p) {
+        result.emplace_back();
+        product = 1;
+      }
+      result.back().push_back(p);
+      product *= p;
+    }
+    return result;
+  }();
+  return groups;
+}
+// 1 if a prime of the table divides num, 2 if num is one, 0 otherwise
+static int TrialDivision(const BigInt& num) {
+  for (const std::vector<Limb>& group : SmallPrimeGroups()) {
+    Limb product = 1;
+    for (Limb p : group) {
+      product *= p;
+    }
+    Limb rem = (num % BigInt(int64_t(product))).ToInt();
+    for (Limb p : group) {
+      if (rem % p == 0) {
+        return num == FromLimb(p) ? 2 : 1;
+      }
+    }
+  }
+  return 0;
+}
+static int JacobiLimb(Limb a, Limb n) {
+  int result = 1;
+  a %= n;
+  while (a != 0) {
+    while (a % 2 == 0) {
+      a /= 2;
+      if (n % 8 == 3 || n % 8 == 5) {
+        result = -result;
+      }
+    }
+    std::swap(a, n);
+    if (a % 4 == 3 && n % 4 == 3) {
+      result = -result;
+    }
+    a %= n;
+  }
+  return n == 1 ? result : 0;
+}
+// Jacobi symbol (a / num) for an odd num > 0, reciprocity brings it down to
+// one limb
+static int Jacobi(int64_t a, const BigInt& num) {
+  Limb low = num.ToInt();
+  int result = 1;
+  Limb value = a >= 0 ? Limb(a) : Limb(0) - Limb(a);
+  if (a < 0 && low % 4 == 3) {
+    result = -result;
+  }
+  if (value == 0) {
+    return num == BigInt(1) ? 1 : 0;
+  }
+  while (value % 2 == 0) {
+    value /= 2;
+    if (low % 8 == 3 || low % 8 == 5) {
+      result = -result;
+    }
+  }
+  if (value == 1) {
+    return result;
+  }
+  if (value % 4 == 3 && low % 4 == 3) {
+    result = -result;
+  }
+  return result * JacobiLimb((num % FromLimb(value)).ToInt(), value);
+}
+// x / 2 modulo an odd num for x in [0, num)
+static BigInt HalveMod(const BigInt& value, const BigInt& num) {
+  return (value.TestBit(0) ? value + num : value) >> 1;
+}
+// lhs - 2 * rhs modulo num for lhs and rhs in [0, num)
+static BigInt SubTwiceMod(BigInt lhs, const BigInt& rhs, const BigInt& num) {
+  for (int i = 0; i < 2; ++i) {
+    lhs -= rhs;
+    if (lhs < BigInt(0)) {
+      lhs += num;
+    }
+  }
+  return lhs;
+}
+bool IsStrongProbablePrime(const BigInt& num, const BigInt& base) {
+  BigInt minus_one = num - BigInt(1);
+  size_t twos = 0;
+  while (!minus_one.TestBit(twos)) {
+    ++twos;
+  }
+  // Montgomery's products are quadratic, Barrett's use the fast multiplier
+  bool quadratic =
+      num.BitLength() < BigInt::mul_thresholds.karatsuba * kLimbBits;
+  ModContext mod(num, quadratic ? ModContext::Reduction::kMontgomery
+                                : ModContext::Reduction::kBarrett);
+  BigInt power = mod.PowMod(base, minus_one >> twos);
+  if (power == BigInt(1) || power == minus_one) {
+    return true;
+  }
+  for (size_t i = 1; i < twos; ++i) {
+    power = mod.MulMod(power, power);
+    if (power == minus_one) {
+      return true;
+    }
+    if (power == BigInt(1)) {
+      return false;
+    }
+  }
+  return false;
+}
+// Selfridge's parameters: the first D of 5, -7, 9, -11, ... with
+// (D / num) = -1, P = 1 and Q = (1 - D) / 4; num + 1 = d * 2^s passes if
+// U_d = 0 or V_(d * 2^r) = 0 for some r < s; a square num would make the
+// search run forever and is rejected first
+static bool IsStrongLucasProbablePrime(const BigInt& num) {
+  BigInt root = ISqrt(num);
+  if (root * root == num) {
+    return false;
+  }
+  int64_t d = 5;
+  for (int jacobi = Jacobi(d, num); jacobi != -1; jacobi = Jacobi(d, num)) {
+    if (jacobi == 0) {
+      return false;
+    }
+    d = d > 0 ? -(d + 2) : 2 - d;
+  }
+  // Barrett keeps the operands in plain form, so the additions and the
+  // halvings between the products need no conversions
+  ModContext mod(num, ModContext::Reduction::kBarrett);
+  BigInt big_d(d);
+  BigInt q = mod.Reduce(BigInt((1 - d) / 4));
+  BigInt index = num + BigInt(1);
+  size_t twos = 0;
+  while (!index.TestBit(twos)) {
+    ++twos;
+  }
+  index = index >> twos;
+  // U_k, V_k and Q^k from k = 1 along the bits of the index
+  BigInt u(1);
+  BigInt v(1);
+  BigInt q_power = q;
+  for (size_t i = index.BitLength() - 1; i-- > 0;) {
+    u = mod.MulMod(u, v);
+    v = SubTwiceMod(mod.MulMod(v, v), q_power, num);
+    q_power = mod.MulMod(q_power, q_power);
+    if (index.TestBit(i)) {
+      BigInt next_u = HalveMod(mod.Reduce(u + v), num);
+      v = HalveMod(mod.Reduce(big_d * u + v), num);
+      u = std::move(next_u);
+      q_power = mod.MulMod(q_power, q);
+    }
+  }
+  if (u == BigInt(0) || v == BigInt(0)) {
+    return true;
+  }
+  for (size_t r = 1; r < twos; ++r) {
+    v = SubTwiceMod(mod.MulMod(v, v), q_power, num);
+    if (v == BigInt(0)) {
+      return true;
+    }
+    q_power = mod.MulMod(q_power, q_power);
+  }
+  return false;
+}
+// the extra bases are drawn from a generator seeded with the low limb of
+// num, so the answer for a given num never changes
+bool IsProbablePrime(const BigInt& num, size_t rounds) {
+  if (num < BigInt(0)) {
+    return IsProbablePrime(-num, rounds);
+  }
+  if (num < BigInt(2)) {
+    return false;
+  }
+  if (!num.TestBit(0)) {
+    return num == BigInt(2);
+  }
+  int trial = TrialDivision(num);
+  if (trial != 0) {
+    return trial == 2;
+  }
+  if (num < FromLimb(kSmallPrimeLimit * kSmallPrimeLimit)) {
+    return true;
+  }
+  if (!IsStrongProbablePrime(num, BigInt(2)) ||
+      !IsStrongLucasProbablePrime(num)) {
+    return false;
+  }
+  std::mt19937_64 gen(num.ToInt());
+  BigInt range = num - BigInt(3);
+  std::vector<Limb> limbs((num.BitLength() + kLimbBits - 1) / kLimbBits);
+  for (size_t i = 0; i < rounds; ++i) {
+    std::generate(limbs.begin(), limbs.end(), gen);
+    if (!IsStrongProbablePrime(num, BigInt(limbs) % range + BigInt(2))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* products and combinatorics */
+// the tree goes down to single numbers, splitting [first, last) where the
+// prefix sums of the limbs pass the middle
+static BigInt ProductRange(std::span<const BigInt> nums,
+                           const std::vector<size_t>& prefix, size_t first,
+                           size_t last) {
+  if (last - first == 1) {
+    return nums[first];
+  }
+  if (last - first == 2) {
+    return nums[first] * nums[first + 1];
+  }
+  size_t half = prefix[first] + (prefix[last] - prefix[first]) / 2;
+  size_t mid = std::upper_bound(prefix.begin() + first + 1,
+                                prefix.begin() + last, half) -
+               prefix.begin();
+  mid = std::clamp(mid, first + 1, last - 1);
+  return ProductRange(nums, prefix, first, mid) *
+         ProductRange(nums, prefix, mid, last);
+}
+BigInt ProductOf(std::span<const BigInt> nums) {
+  if (nums.empty()) {
+    return BigInt(1);
+  }
+  std::vector<size_t> prefix(nums.size() + 1, 0);
+  for (size_t k = 0; k < nums.size(); ++k) {
+    prefix[k + 1] = prefix[k] + BigIntView(nums[k]).Size();
+  }
+  return ProductRange(nums, prefix, 0, nums.size());
+}
+// small factors are multiplied into full limbs first, the tree then starts
+// from numbers of one limb each
+static BigInt ProductOfLimbs(const std::vector<Limb>& factors) {
+  std::vector<BigInt> packed;
+  Limb product = 1;
+  for (Limb factor : factors) {
+    if (product > std::numeric_limits<Limb>::max() / factor) {
+      packed.push_back(FromLimb(product));
+      product = 1;
+    }
+    product *= factor;
+  }
+  packed.push_back(FromLimb(product));
+  return ProductOf(packed);
+}
+// primes up to limit by the sieve of Eratosthenes on the odd numbers
+static std::vector<Limb> PrimesUpTo(size_t limit) {
+  std::vector<Limb> primes;
+  if (limit < 2) {
+    return primes;
+  }
+  primes.push_back(2);
+  // index i stands for 2i + 1
+  std::vector<bool> composite(limit / 2 + 1, false);
+  for (size_t i = 1; 2 * i + 1 <= limit; ++i) {
+    if (composite[i]) {
+      continue;
+    }
+    size_t p = 2 * i + 1;
+    primes.push_back(p);
+    if (p > limit / p) {
+      continue;
+    }
+    for (size_t multiple = p * p; multiple <= limit; multiple += 2 * p) {
+      composite[multiple / 2] = true;
+    }
+  }
+  return primes;
+}
+// odd part of swing(n) = n! / ((n/2)!)^2, the exponent of p in it is the
+// number of odd floor(n / p^i), so primes above sqrt(n) appear at most once
+static BigInt OddSwing(size_t n, const std::vector<Limb>& primes) {
+  std::vector<Limb> factors;
+  for (size_t k = 1; k < primes.size() && primes[k] <= n; ++k) {
+    Limb p = primes[k];
+    if (p > n / p) {
+      if ((n / p) % 2 == 1) {
+        factors.push_back(p);
+      }
+      continue;
+    }
+    Limb power = 1;
+    for (size_t q = n / p; q != 0; q /= p) {
+      if (q % 2 == 1) {
+        power *= p;
+      }
+    }
+    if (power > 1) {
+      factors.push_back(power);
+    }
+  }
+  return ProductOfLimbs(factors);
+}
+static BigInt OddFactorial(size_t n, const std::vector<Limb>& primes) {
+  if (n <= kLimbFactorial) {
+    Limb product = 1;
+    for (Limb k = 2; k <= n; ++k) {
+      product *= k;
+    }
+    return FromLimb(product >> std::countr_zero(product));
+  }
+  BigInt half = OddFactorial(n / 2, primes);
+  return half * half * OddSwing(n, primes);
+}
+// n! holds 2 to the power n minus the number of ones in n, the recursion
+// works on odd parts and the power of two comes back as one shift
+BigInt Factorial(size_t n) {
+  std::vector<Limb> primes = PrimesUpTo(n <= kLimbFactorial ? 0 : n);
+  return OddFactorial(n, primes) << (n - std::popcount(n));
+}
+// by Legendre's formula the exponent of p in n! / (k! (n - k)!) is the sum
+// of floor(n / p^i) - floor(k / p^i) - floor((n - k) / p^i), and p to it
+// never exceeds n
+BigInt Binomial(size_t n, size_t k) {
+  if (k > n) {
+    return BigInt(0);
+  }
+  k = std::min(k, n - k);
+  if (k < n / kDirectBinomialRatio) {
+    std::vector<Limb> factors(k);
+    std::iota(factors.begin(), factors.end(), Limb(n - k + 1));
+    return ProductOfLimbs(factors) / Factorial(k);
+  }
+  std::vector<Limb> factors;
+  for (Limb p : PrimesUpTo(n)) {
+    Limb power = 1;
+    for (size_t scale = p;; scale *= p) {
+      for (size_t e = n / scale - k / scale - (n - k) / scale; e != 0; --e) {
+        power *= p;
+      }
+      if (scale > n / p) {
+        break;
+      }
+    }
+    if (power > 1) {
+      factors.push_back(power);
+    }
+  }
+  return ProductOfLimbs(factors);
+}
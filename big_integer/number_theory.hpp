@@ -0,0 +1,35 @@
+#pragma once
+#include <span>
+
+#include "big_integer.hpp"
+// number theory built on the public BigInt arithmetic, results never depend
+// on the sign of an argument unless stated
+
+// greatest common divisor of |lhs| and |rhs| by Lehmer's algorithm, zero
+// only if both are zero
+BigInt Gcd(const BigInt& lhs, const BigInt& rhs);
+// returns Gcd(lhs, rhs) and sets x and y with lhs * x + rhs * y equal to it
+BigInt ExtendedGcd(const BigInt& lhs, const BigInt& rhs, BigInt& x,
+                   BigInt& y);
+// floor(sqrt(num)) by Newton steps that double the precision, zero for a
+// negative num
+BigInt ISqrt(const BigInt& num);
+// floor of the k-th root of |num| carrying the sign of num for odd k, zero
+// for k == 0 and for a negative num with even k
+BigInt IRoot(const BigInt& num, size_t k);
+// Miller-Rabin round for an odd num > 2, base is reduced modulo num
+bool IsStrongProbablePrime(const BigInt& num, const BigInt& base);
+// Baillie-PSW on |num|, a strong probable prime test to base 2 and a
+// strong Lucas test, followed by rounds Miller-Rabin rounds to pseudorandom
+// bases; no composite passing Baillie-PSW is known
+bool IsProbablePrime(const BigInt& num, size_t rounds = 0);
+
+// product of nums by a tree split where half of the limbs lie, so every
+// multiplication gets operands of about the same length; 1 for no numbers
+BigInt ProductOf(std::span<const BigInt> nums);
+// n! by the prime swing algorithm: n! = ((n/2)!)^2 * swing(n) where the
+// swing is a product of prime powers taken by a product tree
+BigInt Factorial(size_t n);
+// n choose k from the prime factorization of the coefficient, zero for
+// k > n
+BigInt Binomial(size_t n, size_t k);
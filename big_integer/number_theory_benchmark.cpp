@@ -0,0 +1,130 @@
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_integer.hpp"
+#include "number_theory.hpp"
+
+/* Times the number theory toolkit on random operands from 1k decimal digits
+   up to max_digits, then the Baillie-PSW test on Mersenne primes whose
+   exponent is at most max_exponent, and last n! and (2n choose n) next to
+   n! by repeated *= for n up to max_factorial. Usage:
+   big_integer_number_theory_benchmark [max_digits [max_exponent
+   [max_factorial]]] */
+
+struct Column {
+  const char* name;
+  std::function<void(const BigInt&, const BigInt&)> run;
+};
+
+static constexpr size_t kMinDigits = 1000;
+static constexpr size_t kDefaultMaxDigits = 100000;
+static constexpr size_t kDefaultMaxExponent = 11213;
+static constexpr size_t kMinFactorial = 1000;
+static constexpr size_t kDefaultMaxFactorial = 1000000;
+// the quadratic loop only runs up to here
+static constexpr size_t kMaxNaiveFactorial = 100000;
+static constexpr double kMinDurationMs = 50;
+// exponents of Mersenne primes from about 400 to 3400 digits
+static const std::vector<size_t> kMersenneExponents = {1279, 2203, 3217,
+                                                       4423, 9689, 11213};
+
+static BigInt RandomNumber(size_t digits, std::mt19937_64& gen) {
+  std::string number(digits, '0');
+  for (char& digit : number) {
+    digit = char('0' + gen() % 10);
+  }
+  number[0] = char('1' + gen() % 9);
+  return BigInt(number);
+}
+
+static double MeasureMs(const std::function<void()>& run) {
+  size_t runs = 0;
+  double elapsed = 0;
+  while (elapsed < kMinDurationMs) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    auto stop = std::chrono::steady_clock::now();
+    elapsed += std::chrono::duration<double, std::milli>(stop - start).count();
+    ++runs;
+  }
+  return elapsed / runs;
+}
+
+int main(int argc, char** argv) {
+  size_t max_digits = argc > 1 ? std::stoul(argv[1]) : kDefaultMaxDigits;
+  size_t max_exponent = argc > 2 ? std::stoul(argv[2]) : kDefaultMaxExponent;
+  size_t max_factorial =
+      argc > 3 ? std::stoul(argv[3]) : kDefaultMaxFactorial;
+  const std::vector<Column> kColumns = {
+      {"gcd", [](const BigInt& lhs, const BigInt& rhs) { Gcd(lhs, rhs); }},
+      {"ext_gcd",
+       [](const BigInt& lhs, const BigInt& rhs) {
+         BigInt x;
+         BigInt y;
+         ExtendedGcd(lhs, rhs, x, y);
+       }},
+      {"isqrt", [](const BigInt& lhs, const BigInt&) { ISqrt(lhs); }},
+      {"iroot_3", [](const BigInt& lhs, const BigInt&) { IRoot(lhs, 3); }},
+      {"iroot_17", [](const BigInt& lhs, const BigInt&) { IRoot(lhs, 17); }},
+  };
+  std::cout << std::setw(10) << "digits";
+  for (const Column& column : kColumns) {
+    std::cout << std::setw(14) << column.name;
+  }
+  std::cout << "   (ms per call)" << std::endl;
+
+  std::mt19937_64 gen(kMinDigits);
+  for (size_t digits = kMinDigits; digits <= max_digits;
+       digits = (digits % 3 == 0) ? digits / 3 * 10 : digits * 3) {
+    BigInt lhs = RandomNumber(digits, gen);
+    BigInt rhs = RandomNumber(digits, gen);
+    std::cout << std::setw(10) << digits;
+    for (const Column& column : kColumns) {
+      std::cout << std::setw(14) << std::fixed << std::setprecision(4)
+                << MeasureMs([&] { column.run(lhs, rhs); });
+    }
+    std::cout << std::endl;
+  }
+
+  std::cout << std::endl
+            << std::setw(10) << "exponent" << std::setw(14) << "digits"
+            << std::setw(14) << "bpsw" << "   (ms per call)" << std::endl;
+  for (size_t exponent : kMersenneExponents) {
+    if (exponent > max_exponent) {
+      break;
+    }
+    BigInt prime = (BigInt(1) << exponent) - BigInt(1);
+    std::cout << std::setw(10) << exponent << std::setw(14)
+              << prime.ToString().size() << std::setw(14) << std::fixed
+              << std::setprecision(4)
+              << MeasureMs([&] { IsProbablePrime(prime); }) << std::endl;
+  }
+
+  std::cout << std::endl
+            << std::setw(10) << "n" << std::setw(14) << "factorial"
+            << std::setw(14) << "binomial" << std::setw(14) << "naive"
+            << "   (ms per call)" << std::endl;
+  for (size_t n = kMinFactorial; n <= max_factorial; n *= 10) {
+    std::cout << std::setw(10) << n << std::setw(14) << std::fixed
+              << std::setprecision(4) << MeasureMs([&] { Factorial(n); })
+              << std::setw(14) << MeasureMs([&] { Binomial(2 * n, n); })
+              << std::setw(14);
+    if (n <= kMaxNaiveFactorial) {
+      std::cout << MeasureMs([&] {
+        BigInt product(1);
+        for (size_t k = 2; k <= n; ++k) {
+          product *= BigInt(int64_t(k));
+        }
+      });
+    } else {
+      std::cout << "-";
+    }
+    std::cout << std::endl;
+  }
+  return 0;
+}
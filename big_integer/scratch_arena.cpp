@@ -0,0 +1,90 @@
+#include "scratch_arena.hpp"
+
+#include <algorithm>
+#include <new>
+
+static const size_t kAlignment = 64;
+static const size_t kMinBlock = size_t(1) << 16;
+// an arena that needed more than this is emptied when its last frame closes
+static const size_t kMaxRetained = size_t(1) << 26;
+
+static size_t AlignUp(size_t bytes) {
+  return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+ScratchArena::~ScratchArena() { Release(0); }
+ScratchArena& ScratchArena::Local() {
+  static thread_local ScratchArena arena;
+  return arena;
+}
+size_t ScratchArena::Used() const {
+  size_t used = offset_;
+  for (size_t i = 0; i < block_ && i < blocks_.size(); ++i) {
+    used += blocks_[i].size;
+  }
+  return used;
+}
+size_t ScratchArena::Reserved() const {
+  size_t reserved = 0;
+  for (const Block& block : blocks_) {
+    reserved += block.size;
+  }
+  return reserved;
+}
+void ScratchArena::Trim() {
+  if (depth_ == 0) {
+    Release(0);
+  } else if (block_ + 1 < blocks_.size()) {
+    Release(block_ + 1);
+  }
+}
+// a request that does not fit moves on to the next block, which is replaced
+// when it is too small, new blocks at least double so that the count stays
+// logarithmic until the blocks are merged into one of the peak size
+void* ScratchArena::AllocateBytes(size_t bytes) {
+  bytes = AlignUp(std::max<size_t>(bytes, 1));
+  if (blocks_.empty() || offset_ + bytes > blocks_[block_].size) {
+    size_t next = blocks_.empty() ? 0 : block_ + 1;
+    if (next < blocks_.size() && blocks_[next].size < bytes) {
+      Release(next);
+    }
+    if (next == blocks_.size()) {
+      size_t size = std::max({bytes, kMinBlock, peak_,
+                              blocks_.empty() ? 0 : 2 * blocks_.back().size});
+      blocks_.push_back({static_cast<std::byte*>(::operator new(
+                             size, std::align_val_t(kAlignment))),
+                         size});
+    }
+    block_ = next;
+    offset_ = 0;
+  }
+  void* result = blocks_[block_].data + offset_;
+  offset_ += bytes;
+  peak_ = std::max(peak_, Used());
+  return result;
+}
+void ScratchArena::Release(size_t first) {
+  while (blocks_.size() > first) {
+    ::operator delete(blocks_.back().data, std::align_val_t(kAlignment));
+    blocks_.pop_back();
+  }
+}
+
+ScratchArena::Frame::Frame() : Frame(ScratchArena::Local()) {}
+ScratchArena::Frame::Frame(ScratchArena& arena)
+    : arena_(arena), block_(arena.block_), offset_(arena.offset_) {
+  ++arena_.depth_;
+}
+ScratchArena::Frame::~Frame() {
+  arena_.block_ = block_;
+  arena_.offset_ = offset_;
+  if (--arena_.depth_ != 0) {
+    return;
+  }
+  if (arena_.peak_ > kMaxRetained) {
+    arena_.Release(0);
+    arena_.peak_ = 0;
+  } else if (arena_.blocks_.size() > 1) {
+    arena_.Release(0);
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+// per-thread stack of scratch memory for the recursive algorithms: memory
+// taken after a Frame was opened is released when the frame closes, and the
+// blocks are kept for the next operation, so a steady workload does not
+// reach malloc at all
+class ScratchArena {
+ public:
+  ScratchArena() = default;
+  ScratchArena(const ScratchArena&) = delete;
+  ScratchArena& operator=(const ScratchArena&) = delete;
+  ~ScratchArena();
+  // arena of the calling thread
+  static ScratchArena& Local();
+  // uninitialized storage for count trivial objects, 64-byte aligned
+  template <typename T>
+  T* Allocate(size_t count) {
+    return static_cast<T*>(AllocateBytes(count * sizeof(T)));
+  }
+  // bytes handed out and bytes held in blocks
+  size_t Used() const;
+  size_t Reserved() const;
+  // frees the blocks no open frame uses
+  void Trim();
+
+  class Frame {
+   public:
+    Frame();
+    explicit Frame(ScratchArena& arena);
+    Frame(const Frame&) = delete;
+    Frame& operator=(const Frame&) = delete;
+    ~Frame();
+    template <typename T>
+    T* Allocate(size_t count) {
+      return arena_.Allocate<T>(count);
+    }
+
+   private:
+    ScratchArena& arena_;
+    size_t block_;
+    size_t offset_;
+  };
+
+ private:
+  struct Block {
+    std::byte* data;
+    size_t size;
+  };
+  void* AllocateBytes(size_t bytes);
+  void Release(size_t first);
+
+  std::vector<Block> blocks_;
+  // position of the next allocation, blocks after block_ are free
+  size_t block_ = 0;
+  size_t offset_ = 0;
+  size_t depth_ = 0;
+  // most bytes used at once since the blocks were last merged
+  size_t peak_ = 0;
+};
@@ -0,0 +1,977 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "big_decimal.hpp"
+#include "big_integer.hpp"
+#include "big_integer_batch.hpp"
+#include "big_rational.hpp"
+#include "fixed_big_integer.hpp"
+#include "limb_kernels.hpp"
+#include "mod_context.hpp"
+#include "number_theory.hpp"
+#include "scratch_arena.hpp"
+#include "thread_pool.hpp"
+
+using Limb = BigInt::Limb;
+__extension__ using DoubleLimb = unsigned __int128;
+
+// limbs of the magnitude straight from the serialized form, so the
+// reference below does not go through the arithmetic under test
+static std::vector<Limb> MagnitudeLimbs(const BigInt& num) {
+  std::vector<uint8_t> bytes = num.Serialize();
+  std::vector<Limb> limbs((bytes.size() - sizeof(Limb)) / sizeof(Limb));
+  std::memcpy(limbs.data(), bytes.data() + sizeof(Limb),
+              limbs.size() * sizeof(Limb));
+  return limbs;
+}
+static bool IsNegative(const BigInt& num) {
+  return (num.Serialize()[0] & 1) != 0;
+}
+// num mod 2^61 - 1 in [0, p), an independent check for every size
+static const Limb kPrime = (Limb(1) << 61) - 1;
+static Limb Residue(const BigInt& num) {
+  std::vector<Limb> limbs = MagnitudeLimbs(num);
+  DoubleLimb res = 0;
+  for (size_t i = limbs.size(); i-- > 0;) {
+    // 2^64 = 8 modulo 2^61 - 1
+    res = (res * 8 + limbs[i] % kPrime) % kPrime;
+  }
+  Limb abs = Limb(res);
+  return IsNegative(num) && abs != 0 ? kPrime - abs : abs;
+}
+static Limb MulResidue(Limb lhs, Limb rhs) {
+  return Limb(DoubleLimb(lhs) * rhs % kPrime);
+}
+
+// exactly limbs limbs, runs of zero and all-one limbs stress the carries
+static BigInt RandomBigInt(std::mt19937_64& gen, size_t limbs,
+                           bool negative = false) {
+  std::vector<Limb> number(limbs);
+  for (Limb& limb : number) {
+    switch (gen() % 4) {
+      case 0:
+        limb = 0;
+        break;
+      case 1:
+        limb = ~Limb(0);
+        break;
+      default:
+        limb = gen();
+    }
+  }
+  if (limbs != 0) {
+    number.back() |= Limb(1) << (gen() % 64);
+  }
+  return BigInt(!negative, number);
+}
+
+TEST(Limbs, CarryAndBorrowChains) {
+  BigInt top(std::vector<Limb>{~Limb(0)});
+  EXPECT_EQ((top + BigInt(1)).ToString(), "18446744073709551616");
+  EXPECT_TRUE(top + BigInt(1) == BigInt(std::vector<Limb>{0, 1}));
+  BigInt two_limbs = BigInt(std::vector<Limb>{0, 0, 1}) - BigInt(1);
+  EXPECT_EQ(two_limbs.ToString(), "340282366920938463463374607431768211455");
+  EXPECT_TRUE(two_limbs == BigInt(std::vector<Limb>{~Limb(0), ~Limb(0)}));
+  EXPECT_EQ(BigInt(std::numeric_limits<int64_t>::min()).ToString(),
+            "-9223372036854775808");
+  EXPECT_EQ((BigInt(5) - BigInt(7)).ToString(), "-2");
+  EXPECT_EQ((BigInt(-5) + BigInt(5)).ToString(), "0");
+
+  BigInt counter = top;
+  ++counter;
+  EXPECT_TRUE(counter == top + BigInt(1));
+  --counter;
+  EXPECT_TRUE(counter == top);
+  BigInt zero;
+  zero--;
+  EXPECT_EQ(zero, BigInt(-1));
+}
+TEST(Limbs, AdditionMatchesResidues) {
+  std::mt19937_64 gen(14);
+  for (size_t ln = 0; ln < 40; ++ln) {
+    BigInt lhs = RandomBigInt(gen, ln, gen() % 2 == 0);
+    BigInt rhs = RandomBigInt(gen, gen() % 40, gen() % 2 == 0);
+    EXPECT_EQ(Residue(lhs + rhs), (Residue(lhs) + Residue(rhs)) % kPrime);
+    EXPECT_EQ(Residue(lhs - rhs),
+              (Residue(lhs) + kPrime - Residue(rhs)) % kPrime);
+    EXPECT_TRUE(lhs + rhs - rhs == lhs) << ln;
+    EXPECT_TRUE(lhs - lhs == BigInt(0));
+    EXPECT_NE(lhs < rhs, lhs >= rhs);
+    EXPECT_TRUE(lhs < lhs + BigInt(1));
+    EXPECT_EQ(lhs <= rhs, !(lhs > rhs));
+  }
+}
+
+static const size_t kNever = std::numeric_limits<size_t>::max();
+static const BigInt::MulThresholds kSchoolbookOnly = {kNever, kNever, kNever};
+static const BigInt::MulThresholds kKaratsubaOnly = {32, kNever, kNever};
+
+static BigInt MulWith(const BigInt& lhs, const BigInt& rhs,
+                      BigInt::MulThresholds thresholds) {
+  BigInt::MulThresholds saved = BigInt::mul_thresholds;
+  BigInt::mul_thresholds = thresholds;
+  BigInt result = lhs * rhs;
+  BigInt::mul_thresholds = saved;
+  return result;
+}
+static void ExpectProduct(const BigInt& lhs, const BigInt& rhs,
+                          BigInt::MulThresholds reference) {
+  BigInt product = lhs * rhs;
+  EXPECT_EQ(Residue(product), MulResidue(Residue(lhs), Residue(rhs)))
+      << MagnitudeLimbs(lhs).size() << " x " << MagnitudeLimbs(rhs).size();
+  EXPECT_TRUE(product == MulWith(lhs, rhs, reference))
+      << MagnitudeLimbs(lhs).size() << " x " << MagnitudeLimbs(rhs).size();
+}
+// balanced, slightly unbalanced and chunked shapes around each size
+static void CheckTierBoundary(std::mt19937_64& gen, size_t threshold,
+                              BigInt::MulThresholds reference) {
+  for (size_t rn = threshold - 1; rn <= threshold + 1; ++rn) {
+    for (size_t ln : {rn, rn + 1, rn * 3 / 2, 2 * rn - 1, 2 * rn, 3 * rn}) {
+      BigInt lhs = RandomBigInt(gen, ln, gen() % 2 == 0);
+      BigInt rhs = RandomBigInt(gen, rn, gen() % 2 == 0);
+      ExpectProduct(lhs, rhs, reference);
+      ExpectProduct(rhs, lhs, reference);
+    }
+    BigInt square = RandomBigInt(gen, rn);
+    ExpectProduct(square, square, reference);
+  }
+}
+
+TEST(Multiplication, SmallSizesMatchSchoolbook) {
+  std::mt19937_64 gen(1);
+  for (size_t ln = 0; ln < 12; ++ln) {
+    for (size_t rn = 0; rn < 12; ++rn) {
+      ExpectProduct(RandomBigInt(gen, ln, true), RandomBigInt(gen, rn),
+                    kSchoolbookOnly);
+    }
+  }
+  EXPECT_EQ(BigInt(-6) * BigInt(7), BigInt(-42));
+  EXPECT_EQ((BigInt(-6) * BigInt(0)).ToString(), "0");
+}
+TEST(Multiplication, KaratsubaAtThreshold) {
+  std::mt19937_64 gen(2);
+  CheckTierBoundary(gen, BigInt::mul_thresholds.karatsuba, kSchoolbookOnly);
+}
+
+TEST(Multiplication, ToomAtThreshold) {
+  std::mt19937_64 gen(15);
+  CheckTierBoundary(gen, BigInt::mul_thresholds.toom3, kSchoolbookOnly);
+}
+TEST(Multiplication, NttAtThresholds) {
+  std::mt19937_64 gen(3);
+  // lowered thresholds put the transform next to schoolbook products
+  BigInt::MulThresholds saved = BigInt::mul_thresholds;
+  BigInt::mul_thresholds = {4, 8, 64};
+  CheckTierBoundary(gen, 64, kSchoolbookOnly);
+  BigInt::mul_thresholds = saved;
+  // the default threshold against Karatsuba, which the tests above cover
+  size_t ntt = BigInt::mul_thresholds.ntt;
+  for (size_t rn : {ntt - 1, ntt}) {
+    BigInt lhs = RandomBigInt(gen, rn + 17, true);
+    BigInt rhs = RandomBigInt(gen, rn);
+    ExpectProduct(lhs, rhs, kKaratsubaOnly);
+  }
+}
+
+static BigInt Abs(const BigInt& num) { return num < BigInt(0) ? -num : num; }
+
+// quotient rounded towards zero, remainder with the sign of the dividend
+static void ExpectDivMod(const BigInt& num, const BigInt& den) {
+  auto [quot, rem] = num.DivMod(den);
+  size_t nn = MagnitudeLimbs(num).size();
+  size_t dn = MagnitudeLimbs(den).size();
+  EXPECT_TRUE(quot * den + rem == num) << nn << " / " << dn;
+  Limb expected =
+      (MulResidue(Residue(quot), Residue(den)) + Residue(rem)) % kPrime;
+  EXPECT_EQ(expected, Residue(num)) << nn << " / " << dn;
+  EXPECT_TRUE(Abs(rem) < Abs(den)) << nn << " / " << dn;
+  EXPECT_TRUE(rem == BigInt(0) || IsNegative(rem) == IsNegative(num));
+  EXPECT_TRUE(num / den == quot);
+  EXPECT_TRUE(num % den == rem);
+}
+TEST(Division, KnuthAndNewtonAtThresholds) {
+  std::mt19937_64 gen(5);
+  for (size_t dn : {1, 2, 3, 40}) {
+    for (size_t qn : {0, 1, 50, 3000}) {
+      BigInt den = RandomBigInt(gen, dn, gen() % 2 == 0);
+      ExpectDivMod(RandomBigInt(gen, dn + qn, gen() % 2 == 0), den);
+    }
+  }
+  // Newton division needs 2500 limbs of divisor and of quotient
+  for (size_t dn : {2499, 2500, 2501, 5001}) {
+    for (size_t qn : {1, 2499, 2500, 2501}) {
+      BigInt den = RandomBigInt(gen, dn, gen() % 2 == 0);
+      BigInt num = RandomBigInt(gen, dn + qn, gen() % 2 == 0);
+      ExpectDivMod(num, den);
+      // exact multiples and one below them take the correction steps
+      BigInt multiple = (num / den) * den;
+      ExpectDivMod(multiple, den);
+      ExpectDivMod(multiple - BigInt(1), den);
+    }
+  }
+}
+TEST(Division, SmallCases) {
+  EXPECT_EQ(BigInt(-7) / BigInt(2), BigInt(-3));
+  EXPECT_EQ(BigInt(-7) % BigInt(2), BigInt(-1));
+  EXPECT_EQ(BigInt(7) % BigInt(-2), BigInt(1));
+  EXPECT_EQ((BigInt(-1) / BigInt(2)).ToString(), "0");
+  EXPECT_EQ(BigInt(3) / BigInt(5), BigInt(0));
+}
+
+TEST(CompoundOperators, MatchBinaryOperators) {
+  std::mt19937_64 gen(16);
+  for (int i = 0; i < 200; ++i) {
+    BigInt lhs = RandomBigInt(gen, gen() % 8, gen() % 2 == 0);
+    BigInt rhs = RandomBigInt(gen, gen() % 8, gen() % 2 == 0);
+    BigInt result = lhs;
+    result += rhs;
+    EXPECT_TRUE(result == lhs + rhs);
+    result = lhs;
+    result -= rhs;
+    EXPECT_TRUE(result == lhs - rhs);
+    result = lhs;
+    result *= rhs;
+    EXPECT_TRUE(result == lhs * rhs);
+    if (rhs != BigInt(0)) {
+      result = lhs;
+      result /= rhs;
+      EXPECT_TRUE(result == lhs / rhs);
+    }
+    // temporaries on the left hand side are reused as the result
+    EXPECT_TRUE(BigInt(lhs) + rhs == lhs + rhs);
+    EXPECT_TRUE(BigInt(lhs) - rhs == lhs - rhs);
+  }
+}
+TEST(CompoundOperators, AliasedOperandsAndMoves) {
+  std::mt19937_64 gen(17);
+  BigInt num = RandomBigInt(gen, 5, true);
+  BigInt copy = num;
+  copy += copy;
+  EXPECT_TRUE(copy == num * BigInt(2));
+  copy *= copy;
+  EXPECT_TRUE(copy == num * num * BigInt(4));
+  copy /= copy;
+  EXPECT_EQ(copy, BigInt(1));
+  copy = num;
+  copy -= copy;
+  EXPECT_EQ(copy.ToString(), "0");
+
+  copy = num;
+  BigInt moved(std::move(copy));
+  EXPECT_TRUE(moved == num);
+  copy = num + BigInt(1);
+  EXPECT_TRUE(copy == num + BigInt(1));
+  BigInt assigned;
+  assigned = std::move(moved);
+  EXPECT_TRUE(assigned == num);
+}
+
+TEST(CompoundOperators, PlusAndMinusMatchOperators) {
+  std::mt19937_64 gen(26);
+  // the benchmark times both sign branches of these
+  for (int i = 0; i < 100; ++i) {
+    BigInt lhs = RandomBigInt(gen, gen() % 5, gen() % 2 == 0);
+    BigInt rhs = RandomBigInt(gen, gen() % 5, gen() % 2 == 0);
+    EXPECT_TRUE(BigInt(lhs).Plus(rhs) == lhs + rhs);
+    EXPECT_TRUE(BigInt(lhs).Minus(rhs) == lhs - rhs);
+    EXPECT_TRUE(BigInt(lhs).Plus(-rhs) == lhs - rhs);
+  }
+}
+
+// 19 digits at a time by single limb divisions
+static std::string NaiveDecimal(BigInt num) {
+  if (num == BigInt(0)) {
+    return "0";
+  }
+  bool negative = num < BigInt(0);
+  num = Abs(num);
+  BigInt base(std::vector<Limb>{10000000000000000000ULL});
+  std::string digits;
+  while (num != BigInt(0)) {
+    auto [quot, rem] = num.DivMod(base);
+    std::string chunk = std::to_string(rem.ToInt());
+    if (quot != BigInt(0)) {
+      chunk.insert(0, 19 - chunk.size(), '0');
+    }
+    digits.insert(0, chunk);
+    num = quot;
+  }
+  return (negative ? "-" : "") + digits;
+}
+static BigInt NaiveParse(const std::string& digits) {
+  BigInt result;
+  for (char digit : digits) {
+    result = result * BigInt(10) + BigInt(digit - '0');
+  }
+  return result;
+}
+TEST(Conversion, ToCharsAroundRadixThreshold) {
+  std::mt19937_64 gen(6);
+  for (size_t limbs : {0, 1, 2, 29, 30, 31, 60, 61, 62, 500, 2000}) {
+    BigInt num = RandomBigInt(gen, limbs, gen() % 2 == 0);
+    std::string expected = NaiveDecimal(num);
+    EXPECT_EQ(num.ToString(), expected) << limbs;
+
+    std::vector<char> buffer(expected.size());
+    auto [end, ec] = ToChars(buffer.data(), buffer.data() + buffer.size(), num);
+    ASSERT_EQ(ec, std::errc()) << limbs;
+    EXPECT_EQ(std::string(buffer.data(), end), expected);
+    EXPECT_EQ(ToChars(buffer.data(), buffer.data() + buffer.size() - 1, num).ec,
+              std::errc::value_too_large);
+
+    BigInt parsed;
+    auto result =
+        FromChars(expected.data(), expected.data() + expected.size(), parsed);
+    ASSERT_EQ(result.ec, std::errc()) << limbs;
+    EXPECT_EQ(result.ptr, expected.data() + expected.size());
+    EXPECT_TRUE(parsed == num) << limbs;
+    EXPECT_TRUE(BigInt(expected) == num);
+    std::stringstream stream(expected);
+    BigInt streamed;
+    stream >> streamed;
+    EXPECT_TRUE(streamed == num);
+  }
+}
+TEST(Conversion, FromCharsAroundRadixThreshold) {
+  std::mt19937_64 gen(7);
+  // the parser splits strings longer than 30 limbs of 19 digits
+  for (size_t len : {1, 19, 20, 569, 570, 571, 1140, 1141, 20000}) {
+    std::string digits(len, '0');
+    for (char& digit : digits) {
+      digit = char('0' + gen() % 10);
+    }
+    digits[0] = char('1' + gen() % 9);
+    BigInt parsed;
+    std::string text = "-" + digits + "x";
+    auto result = FromChars(text.data(), text.data() + text.size(), parsed);
+    ASSERT_EQ(result.ec, std::errc()) << len;
+    EXPECT_EQ(result.ptr, text.data() + text.size() - 1);
+    EXPECT_TRUE(parsed == -NaiveParse(digits)) << len;
+    EXPECT_EQ(parsed.ToString(), "-" + digits);
+  }
+  BigInt num(5);
+  std::string bad = "-x";
+  EXPECT_EQ(FromChars(bad.data(), bad.data() + bad.size(), num).ec,
+            std::errc::invalid_argument);
+  EXPECT_EQ(num, BigInt(5));
+  std::string zero = "-000";
+  FromChars(zero.data(), zero.data() + zero.size(), num);
+  EXPECT_EQ(num.ToString(), "0");
+}
+
+TEST(InlineStorage, LimbVectorSpillsAndMoves) {
+  LimbVector limbs{1, 2};
+  EXPECT_EQ(limbs.capacity(), LimbVector::kInlineLimbs);
+  const Limb* inline_data = limbs.data();
+  limbs.push_back(3);
+  EXPECT_NE(limbs.data(), inline_data);
+  EXPECT_TRUE(limbs == LimbVector({1, 2, 3}));
+  limbs.erase(limbs.begin(), limbs.begin() + 2);
+  limbs.insert(limbs.begin(), 2, 7);
+  EXPECT_TRUE(limbs == LimbVector({7, 7, 3}));
+
+  // a heap buffer moves over, inline limbs are copied and the source is
+  // left empty either way
+  const Limb* heap_data = limbs.data();
+  LimbVector moved(std::move(limbs));
+  EXPECT_EQ(moved.data(), heap_data);
+  EXPECT_TRUE(limbs.empty());
+  LimbVector small{4};
+  LimbVector taken(std::move(small));
+  EXPECT_TRUE(taken == LimbVector({4}));
+  EXPECT_TRUE(small.empty());
+  moved = std::move(taken);
+  EXPECT_TRUE(moved == LimbVector({4}));
+  EXPECT_EQ(moved.capacity(), LimbVector::kInlineLimbs);
+}
+TEST(InlineStorage, ValuesCrossTheInlineSize) {
+  std::mt19937_64 gen(18);
+  for (int i = 0; i < 100; ++i) {
+    BigInt small = RandomBigInt(gen, 1 + gen() % 2, gen() % 2 == 0);
+    BigInt large = RandomBigInt(gen, 3 + gen() % 3, gen() % 2 == 0);
+    BigInt num = small;
+    num *= large;
+    EXPECT_EQ(Residue(num), MulResidue(Residue(small), Residue(large)));
+    num /= large;
+    EXPECT_TRUE(num == small);
+    num = large;
+    num = small;
+    EXPECT_TRUE(num == small);
+    BigInt copy(large);
+    copy = std::move(num);
+    EXPECT_TRUE(copy == small);
+  }
+}
+
+TEST(LazyExpressions, MatchEagerArithmetic) {
+  std::mt19937_64 gen(19);
+  const int64_t kMin = std::numeric_limits<int64_t>::min();
+  for (int i = 0; i < 100; ++i) {
+    BigInt a = RandomBigInt(gen, gen() % 6, gen() % 2 == 0);
+    BigInt b = RandomBigInt(gen, gen() % 6, gen() % 2 == 0);
+    BigInt c = RandomBigInt(gen, gen() % 6, gen() % 2 == 0);
+    int64_t k = int64_t(gen());
+    BigInt fused = Lazy(a) * 3 - Lazy(b) * k + c;
+    EXPECT_TRUE(fused == a * BigInt(3) - b * BigInt(k) + c);
+    fused = -(kMin * Lazy(a)) - b;
+    EXPECT_TRUE(fused == -(a * BigInt(kMin)) - b);
+    // more terms than fit on the stack of the evaluation
+    fused = Lazy(a) + b + c + a + b + c + a + b + c + Lazy(a) * -3;
+    EXPECT_TRUE(fused == (b + c) * BigInt(3));
+    // the result may be one of the operands
+    BigInt expected = a * BigInt(2) - c;
+    a = Lazy(a) * 2 - c;
+    EXPECT_TRUE(a == expected);
+  }
+}
+
+TEST(LazyExpressions, ScalesPastALimb) {
+  std::mt19937_64 gen(29);
+  const int64_t kMin = std::numeric_limits<int64_t>::min();
+  BigInt a = RandomBigInt(gen, 3, true);
+  BigInt b = RandomBigInt(gen, 2);
+  int64_t k = (int64_t(1) << 62) + 12345;
+  BigInt fused = Lazy(a) * k * -k * 3 + b;
+  EXPECT_TRUE(fused == a * BigInt(k) * BigInt(-k) * BigInt(3) + b);
+  fused = -(Lazy(a) * kMin * kMin) - Lazy(b) * kMin * 2;
+  EXPECT_TRUE(fused == -(a * BigInt(kMin) * BigInt(kMin)) -
+                           b * BigInt(kMin) * BigInt(2));
+}
+
+TEST(ModContext, ReductionsMatchRemainder) {
+  std::mt19937_64 gen(9);
+  for (size_t limbs : {1, 2, 5, 40}) {
+    for (bool odd : {true, false}) {
+      BigInt modulus = RandomBigInt(gen, limbs);
+      if (modulus.TestBit(0) != odd) {
+        modulus += BigInt(1);
+      }
+      for (auto reduction : {ModContext::Reduction::kMontgomery,
+                             ModContext::Reduction::kBarrett}) {
+        ModContext context(modulus, reduction);
+        BigInt lhs = RandomBigInt(gen, 2 * limbs, true);
+        BigInt rhs = RandomBigInt(gen, limbs);
+        BigInt expected = (lhs * rhs) % modulus;
+        if (expected < BigInt(0)) {
+          expected += modulus;
+        }
+        EXPECT_TRUE(context.MulMod(lhs, rhs) == expected) << limbs;
+        BigInt reduced = lhs % modulus;
+        if (reduced < BigInt(0)) {
+          reduced += modulus;
+        }
+        EXPECT_TRUE(context.Reduce(lhs) == reduced);
+        BigInt base = RandomBigInt(gen, limbs);
+        BigInt power(1);
+        for (int k = 0; k < 37; ++k) {
+          power = power * base % modulus;
+        }
+        EXPECT_TRUE(context.PowMod(base, BigInt(37)) == power) << limbs;
+      }
+    }
+  }
+}
+
+TEST(ModContext, DegenerateModuli) {
+  ModContext negative(BigInt(-7));
+  EXPECT_EQ(negative.Modulus(), BigInt(7));
+  EXPECT_EQ(negative.Reduce(BigInt(-1)), BigInt(6));
+  EXPECT_EQ(negative.PowMod(BigInt(3), BigInt(-6)), BigInt(1));
+  for (int64_t modulus : {0, 1}) {
+    ModContext context{BigInt(modulus)};
+    EXPECT_EQ(context.Reduce(BigInt(12345)).ToString(), "0");
+    EXPECT_EQ(context.PowMod(BigInt(2), BigInt(0)).ToString(), "0");
+  }
+  // an even modulus falls back to Barrett
+  EXPECT_EQ(ModContext(BigInt(10)).GetReduction(),
+            ModContext::Reduction::kBarrett);
+}
+
+TEST(LimbKernels, EveryIsaMatchesScalar) {
+  std::mt19937_64 gen(8);
+  LimbIsa active = ActiveLimbIsa();
+  for (LimbIsa isa : {LimbIsa::kAvx2, LimbIsa::kAvx512}) {
+    if (isa > BestLimbIsa()) {
+      continue;
+    }
+    for (size_t n = 0; n < 70; ++n) {
+      std::vector<Limb> lhs(n);
+      std::vector<Limb> rhs(n);
+      std::vector<Limb> flags(n);
+      for (size_t i = 0; i < n; ++i) {
+        lhs[i] = gen() % 3 == 0 ? ~Limb(0) : gen();
+        rhs[i] = gen() % 3 == 0 ? ~Limb(0) : gen();
+        flags[i] = gen() % 2;
+      }
+      Limb mult = gen();
+      std::vector<Limb> same = lhs;
+      if (n != 0) {
+        same[gen() % n] ^= 1;
+      }
+      auto run = [&](LimbIsa with) {
+        SelectLimbIsa(with);
+        std::vector<Limb> out(6 * n + 4);
+        Limb* res = out.data();
+        out[6 * n] = LimbAddN(res, lhs.data(), rhs.data(), n);
+        out[6 * n + 1] = LimbSubN(res + n, lhs.data(), rhs.data(), n);
+        out[6 * n + 2] = LimbMulWord(res + 2 * n, lhs.data(), n, mult);
+        out[6 * n + 3] = Limb(LimbCompareN(lhs.data(), same.data(), n) + 1) |
+                         Limb(LimbCompareN(lhs.data(), lhs.data(), n) + 1) << 2;
+        std::vector<Limb> carry = flags;
+        LimbLanesAdd(res + 3 * n, lhs.data(), rhs.data(), carry.data(), n);
+        std::vector<Limb> borrow = flags;
+        LimbLanesSub(res + 4 * n, lhs.data(), rhs.data(), borrow.data(), n);
+        std::vector<Limb> acc = rhs;
+        std::vector<Limb> high = lhs;
+        LimbLanesMulAdd(acc.data(), high.data(), lhs.data(), rhs.data(), n);
+        std::copy(acc.begin(), acc.end(), res + 5 * n);
+        out.insert(out.end(), carry.begin(), carry.end());
+        out.insert(out.end(), borrow.begin(), borrow.end());
+        out.insert(out.end(), high.begin(), high.end());
+        // the result may alias an operand
+        std::vector<Limb> aliased = lhs;
+        out.push_back(LimbAddN(aliased.data(), aliased.data(), rhs.data(), n));
+        out.insert(out.end(), aliased.begin(), aliased.end());
+        return out;
+      };
+      EXPECT_EQ(run(isa), run(LimbIsa::kScalar)) << int(isa) << " n=" << n;
+    }
+  }
+  SelectLimbIsa(active);
+}
+
+TEST(LimbKernels, ArithmeticIndependentOfIsa) {
+  std::mt19937_64 gen(20);
+  LimbIsa active = ActiveLimbIsa();
+  for (size_t limbs : {1, 3, 4, 5, 8, 9, 64, 65}) {
+    BigInt lhs = RandomBigInt(gen, limbs, gen() % 2 == 0);
+    BigInt rhs = RandomBigInt(gen, limbs - gen() % 2, gen() % 2 == 0);
+    auto run = [&](LimbIsa isa) {
+      SelectLimbIsa(isa);
+      return std::vector<BigInt>{lhs + rhs, lhs - rhs, lhs * BigInt(-12345),
+                                 BigInt(lhs < rhs)};
+    };
+    EXPECT_TRUE(run(BestLimbIsa()) == run(LimbIsa::kScalar)) << limbs;
+  }
+  SelectLimbIsa(active);
+}
+
+TEST(Parallel, MultiplicationMatchesSerial) {
+  std::mt19937_64 gen(4);
+  BigInt::ThreadOptions saved = BigInt::thread_options;
+  for (size_t limbs : {300, 3000, 20000}) {
+    BigInt lhs = RandomBigInt(gen, limbs);
+    BigInt rhs = RandomBigInt(gen, limbs - 7, true);
+    BigInt::thread_options = {1, kNever};
+    BigInt serial = lhs * rhs;
+    BigInt::thread_options = {4, 64};
+    EXPECT_TRUE(lhs * rhs == serial) << limbs;
+  }
+  BigInt::thread_options = saved;
+}
+TEST(Parallel, NestedGroupsRunEveryTask) {
+  ThreadPool pool(3);
+  ThreadPool::Scope scope(&pool);
+  std::vector<size_t> hits(10000);
+  TaskGroup outer(pool);
+  for (size_t part = 0; part < 4; ++part) {
+    outer.Run([&, part] {
+      ParallelFor(2500, 100, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+          ++hits[part * 2500 + i];
+        }
+      });
+    });
+  }
+  outer.Wait();
+  EXPECT_EQ(std::count(hits.begin(), hits.end(), 1), 10000);
+}
+
+TEST(Parallel, WaitRethrowsAfterEveryTaskFinished) {
+  ThreadPool pool(2);
+  std::atomic<size_t> finished{0};
+  {
+    TaskGroup group(pool);
+    for (size_t i = 0; i < 100; ++i) {
+      group.Run([&, i] {
+        if (i % 10 == 3) {
+          throw std::runtime_error("task " + std::to_string(i));
+        }
+        ++finished;
+      });
+    }
+    EXPECT_THROW(group.Wait(), std::runtime_error);
+    EXPECT_EQ(finished.load(), 90);
+    // the exception is reported once
+    group.Run([&] { ++finished; });
+    EXPECT_NO_THROW(group.Wait());
+    // the destructor only waits
+    group.Run([] { throw std::runtime_error("dropped"); });
+  }
+  EXPECT_EQ(finished.load(), 91);
+}
+
+TEST(Bitwise, MatchesTwosComplementOfInt64) {
+  std::mt19937_64 gen(21);
+  for (int i = 0; i < 500; ++i) {
+    int64_t lhs = int64_t(gen()) >> (gen() % 64);
+    int64_t rhs = int64_t(gen()) >> (gen() % 64);
+    size_t shift = gen() % 64;
+    EXPECT_EQ(BigInt(lhs) & BigInt(rhs), BigInt(lhs & rhs));
+    EXPECT_EQ(BigInt(lhs) | BigInt(rhs), BigInt(lhs | rhs));
+    EXPECT_EQ(BigInt(lhs) ^ BigInt(rhs), BigInt(lhs ^ rhs));
+    EXPECT_EQ(~BigInt(lhs), BigInt(~lhs));
+    EXPECT_EQ(BigInt(lhs) >> shift, BigInt(lhs >> shift));
+    EXPECT_EQ(BigInt(lhs).TestBit(shift), ((lhs >> shift) & 1) != 0);
+  }
+}
+TEST(Bitwise, IdentitiesOnManyLimbs) {
+  std::mt19937_64 gen(22);
+  for (int i = 0; i < 100; ++i) {
+    BigInt lhs = RandomBigInt(gen, gen() % 10, gen() % 2 == 0);
+    BigInt rhs = RandomBigInt(gen, gen() % 10, gen() % 2 == 0);
+    size_t shift = gen() % 200;
+    EXPECT_TRUE((lhs & rhs) + (lhs | rhs) == lhs + rhs);
+    EXPECT_TRUE((lhs ^ rhs) == (lhs | rhs) - (lhs & rhs));
+    EXPECT_TRUE(~lhs == -lhs - BigInt(1));
+    BigInt power = BigInt(1) << shift;
+    EXPECT_TRUE((lhs << shift) == lhs * power);
+    // >> rounds towards minus infinity
+    auto [quot, rem] = lhs.DivMod(power);
+    if (rem < BigInt(0)) {
+      --quot;
+    }
+    EXPECT_TRUE((lhs >> shift) == quot);
+    BigInt assigned = lhs;
+    assigned ^= rhs;
+    assigned ^= rhs;
+    EXPECT_TRUE(assigned == lhs);
+  }
+  BigInt mersenne = (BigInt(1) << 127) - BigInt(1);
+  EXPECT_EQ(mersenne.PopCount(), 127);
+  EXPECT_EQ(mersenne.BitLength(), 127);
+  EXPECT_EQ((-mersenne).PopCount(), 127);
+  EXPECT_TRUE((-mersenne).TestBit(1000));
+  EXPECT_EQ(BigInt(0).BitLength(), 0);
+}
+
+TEST(ScratchArena, FramesReleaseTheirMemory) {
+  ScratchArena arena;
+  size_t peak = 0;
+  {
+    ScratchArena::Frame outer(arena);
+    Limb* small = outer.Allocate<Limb>(10);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % 64, 0);
+    size_t used = arena.Used();
+    EXPECT_GE(used, 10 * sizeof(Limb));
+    {
+      ScratchArena::Frame inner(arena);
+      Limb* large = inner.Allocate<Limb>(100000);
+      std::fill(large, large + 100000, 1);
+      peak = arena.Used();
+    }
+    EXPECT_EQ(arena.Used(), used);
+  }
+  EXPECT_EQ(arena.Used(), 0);
+  // the blocks are merged into one of the peak size once all frames close
+  {
+    ScratchArena::Frame frame(arena);
+    frame.Allocate<Limb>(10);
+    frame.Allocate<Limb>(100000);
+    EXPECT_GE(arena.Reserved(), peak);
+    EXPECT_LT(arena.Reserved(), 2 * peak);
+  }
+  arena.Trim();
+  EXPECT_EQ(arena.Reserved(), 0);
+}
+TEST(ScratchArena, ArithmeticLeavesNothingInUse) {
+  std::mt19937_64 gen(23);
+  BigInt lhs = RandomBigInt(gen, 3000);
+  BigInt rhs = RandomBigInt(gen, 2000, true);
+  BigInt product = lhs * rhs;
+  EXPECT_TRUE(product / rhs == lhs);
+  EXPECT_EQ(ScratchArena::Local().Used(), 0);
+}
+
+TEST(NumberTheory, GcdAndExtendedGcd) {
+  std::mt19937_64 gen(13);
+  BigInt lhs = RandomBigInt(gen, 30);
+  BigInt rhs = RandomBigInt(gen, 20, true);
+  BigInt common = RandomBigInt(gen, 10);
+  BigInt gcd = Gcd(lhs * common, rhs * common);
+  EXPECT_TRUE((lhs * common) % gcd == BigInt(0));
+  EXPECT_TRUE(gcd % common == BigInt(0));
+  BigInt x;
+  BigInt y;
+  EXPECT_TRUE(ExtendedGcd(lhs, rhs, x, y) == Gcd(lhs, rhs));
+  EXPECT_TRUE(lhs * x + rhs * y == Gcd(lhs, rhs));
+  EXPECT_EQ(Gcd(BigInt(0), BigInt(-12)), BigInt(12));
+  EXPECT_EQ(Gcd(BigInt(0), BigInt(0)).ToString(), "0");
+}
+TEST(NumberTheory, RootsBracketTheirArgument) {
+  std::mt19937_64 gen(24);
+  for (size_t limbs : {1, 2, 7, 40}) {
+    BigInt num = RandomBigInt(gen, limbs);
+    BigInt root = ISqrt(num);
+    EXPECT_TRUE(root * root <= num) << limbs;
+    EXPECT_TRUE((root + BigInt(1)) * (root + BigInt(1)) > num) << limbs;
+    for (size_t k : {3, 5}) {
+      BigInt cube = IRoot(-num, k);
+      BigInt power(-1);
+      BigInt next(-1);
+      for (size_t i = 0; i < k; ++i) {
+        power *= -cube;
+        next *= -cube + BigInt(1);
+      }
+      EXPECT_TRUE(power >= -num && next < -num) << limbs << " " << k;
+    }
+  }
+  EXPECT_EQ(ISqrt(BigInt(-4)).ToString(), "0");
+  EXPECT_EQ(IRoot(BigInt(-8), 2).ToString(), "0");
+}
+TEST(NumberTheory, Primality) {
+  EXPECT_TRUE(
+      IsProbablePrime(BigInt("170141183460469231731687303715884105727")));
+  EXPECT_TRUE(IsProbablePrime(BigInt(-7)));
+  EXPECT_TRUE(IsProbablePrime(BigInt(2)));
+  EXPECT_FALSE(IsProbablePrime(BigInt(561)));
+  EXPECT_FALSE(IsProbablePrime(BigInt(1)));
+  EXPECT_FALSE(IsProbablePrime(BigInt(0)));
+  // 2047 = 23 * 89 is a strong pseudoprime to base 2 only
+  EXPECT_TRUE(IsStrongProbablePrime(BigInt(2047), BigInt(2)));
+  EXPECT_FALSE(IsStrongProbablePrime(BigInt(2047), BigInt(3)));
+  EXPECT_FALSE(IsProbablePrime(BigInt(2047)));
+}
+
+TEST(Serialization, RoundTripAndViews) {
+  std::mt19937_64 gen(12);
+  for (size_t limbs : {0, 1, 2, 3, 100}) {
+    BigInt lhs = RandomBigInt(gen, limbs, gen() % 2 == 0);
+    BigInt rhs = RandomBigInt(gen, limbs / 2 + 1, gen() % 2 == 0);
+    std::vector<uint8_t> bytes = lhs.Serialize();
+    ASSERT_EQ(bytes.size(), lhs.SerializedSize());
+    BigInt back;
+    EXPECT_EQ(Deserialize(bytes.data(), bytes.data() + bytes.size(), back),
+              bytes.data() + bytes.size());
+    EXPECT_TRUE(back == lhs);
+    EXPECT_EQ(Deserialize(bytes.data(), bytes.data() + bytes.size() - 1, back),
+              nullptr);
+    BigInt dest;
+    Add(dest, lhs, rhs);
+    EXPECT_TRUE(dest == lhs + rhs);
+    Sub(dest, lhs, rhs);
+    EXPECT_TRUE(dest == lhs - rhs);
+    Mul(dest, lhs, rhs);
+    EXPECT_TRUE(dest == lhs * rhs);
+  }
+}
+
+TEST(Serialization, ViewsOverSerializedLimbs) {
+  std::mt19937_64 gen(25);
+  BigInt first = RandomBigInt(gen, 4, true);
+  BigInt second = RandomBigInt(gen, 2);
+  // two numbers back to back in one 8-byte aligned buffer
+  std::vector<Limb> buffer(first.SerializedSize() / sizeof(Limb) +
+                           second.SerializedSize() / sizeof(Limb));
+  uint8_t* bytes = reinterpret_cast<uint8_t*>(buffer.data());
+  uint8_t* end = second.Serialize(first.Serialize(bytes));
+  BigIntView lhs;
+  BigIntView rhs;
+  const uint8_t* next = DeserializeView(bytes, end, lhs);
+  ASSERT_NE(next, nullptr);
+  EXPECT_EQ(DeserializeView(next, end, rhs), end);
+  EXPECT_TRUE(lhs.ToBigInt() == first);
+  EXPECT_TRUE(rhs.ToBigInt() == second);
+  EXPECT_EQ(Compare(lhs, rhs), -1);
+  EXPECT_TRUE(-lhs > rhs);
+  EXPECT_EQ(DeserializeView(bytes + 1, end, lhs), nullptr);
+
+  // leading zero limbs are skipped and zero is never negative
+  Limb padded[] = {5, 0, 0};
+  EXPECT_EQ(BigIntView(padded, 3, true).Size(), 1);
+  EXPECT_FALSE(BigIntView(padded + 1, 2, true).IsNegative());
+}
+
+TEST(FixedBigInt, MatchesBigIntModulo) {
+  using Fixed = FixedBigInt<256>;
+  static_assert((Fixed(7) * Fixed(6)).GetLimbs()[0] == 42);
+  static_assert((Fixed(0) - Fixed(1)).PopCount() == 256);
+  std::mt19937_64 gen(10);
+  BigInt mask = (BigInt(1) << 256) - BigInt(1);
+  for (int i = 0; i < 200; ++i) {
+    BigInt lhs = RandomBigInt(gen, 1 + gen() % 4);
+    BigInt rhs = RandomBigInt(gen, 1 + gen() % 4);
+    Fixed a{BigIntView(lhs)};
+    Fixed b{BigIntView(rhs)};
+    size_t shift = gen() % 300;
+    EXPECT_TRUE((a + b).ToBigInt() == ((lhs + rhs) & mask));
+    EXPECT_TRUE((a - b).ToBigInt() == ((lhs - rhs) & mask));
+    EXPECT_TRUE((a * b).ToBigInt() == ((lhs * rhs) & mask));
+    EXPECT_TRUE(a.MulWide(b).ToBigInt() == lhs * rhs);
+    EXPECT_TRUE((a / b).ToBigInt() == lhs / rhs);
+    EXPECT_TRUE((a % b).ToBigInt() == lhs % rhs);
+    EXPECT_TRUE((a << shift).ToBigInt() == ((lhs << shift) & mask));
+    EXPECT_TRUE((a >> shift).ToBigInt() == (lhs >> shift));
+    EXPECT_TRUE((a ^ b).ToBigInt() == (lhs ^ rhs));
+    EXPECT_EQ(a < b, lhs < rhs);
+    EXPECT_EQ(Fixed(lhs.ToString()), a);
+  }
+}
+
+TEST(FixedBigInt, SignedValuesWrapLikeUnsigned) {
+  using Fixed = FixedBigInt<256>;
+  static_assert(Fixed(-1) == Fixed(0) - Fixed(1));
+  static_assert(Fixed(-1).PopCount() == 256);
+  static_assert(Fixed(int8_t(-2)) + Fixed(2) == Fixed(0));
+  static_assert(Fixed(~uint32_t(0)).PopCount() == 32);
+  Fixed minus_one = -1;
+  EXPECT_TRUE(minus_one.ToBigInt() == (BigInt(1) << 256) - BigInt(1));
+  int64_t min = std::numeric_limits<int64_t>::min();
+  EXPECT_TRUE(Fixed(min) == Fixed{BigIntView(BigInt(min))});
+  EXPECT_TRUE(Fixed(int64_t(12345)).ToBigInt() == BigInt(12345));
+}
+
+TEST(BigIntBatch, MatchesScalarArithmetic) {
+  std::mt19937_64 gen(11);
+  std::vector<BigInt> lhs;
+  std::vector<BigInt> rhs;
+  for (int i = 0; i < 100; ++i) {
+    lhs.push_back(RandomBigInt(gen, gen() % 6, gen() % 2 == 0));
+    rhs.push_back(RandomBigInt(gen, gen() % 6, gen() % 2 == 0));
+  }
+  BigIntBatch a(lhs);
+  BigIntBatch b(rhs);
+  BigIntBatch sum;
+  BigIntBatch diff;
+  BigIntBatch product;
+  Add(sum, a, b);
+  Sub(diff, a, b);
+  Mul(product, a, b);
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    EXPECT_TRUE(sum.Get(i) == lhs[i] + rhs[i]) << i;
+    EXPECT_TRUE(diff.Get(i) == lhs[i] - rhs[i]) << i;
+    EXPECT_TRUE(product.Get(i) == lhs[i] * rhs[i]) << i;
+  }
+}
+
+TEST(BigIntBatch, WidensAndRunsOnThePool) {
+  std::mt19937_64 gen(27);
+  BigIntBatch batch(3);
+  EXPECT_EQ(batch.Get(1).ToString(), "0");
+  BigInt wide = RandomBigInt(gen, 7, true);
+  batch.Set(1, wide);
+  EXPECT_GE(batch.Width(), 7);
+  EXPECT_TRUE(batch.Get(1) == wide);
+  // dest may be an operand
+  Add(batch, batch, batch);
+  EXPECT_TRUE(batch.Get(1) == wide * BigInt(2));
+
+  std::vector<BigInt> nums;
+  for (int i = 0; i < 3000; ++i) {
+    nums.push_back(RandomBigInt(gen, 1 + gen() % 3, gen() % 2 == 0));
+  }
+  BigIntBatch many(nums);
+  BigIntBatch squares;
+  BigInt::ThreadOptions saved = BigInt::thread_options;
+  BigInt::thread_options = {4, 64};
+  Mul(squares, many, many);
+  BigInt::thread_options = saved;
+  std::vector<BigInt> result = squares.ToVector();
+  ASSERT_EQ(result.size(), nums.size());
+  for (size_t i = 0; i < nums.size(); ++i) {
+    EXPECT_TRUE(result[i] == nums[i] * nums[i]) << i;
+  }
+}
+
+TEST(Factorial, MatchesRunningProduct) {
+  BigInt factorial(1);
+  for (size_t n = 1; n <= 300; ++n) {
+    factorial *= BigInt(int64_t(n));
+    ASSERT_TRUE(Factorial(n) == factorial) << n;
+  }
+  EXPECT_EQ(Factorial(0), BigInt(1));
+  EXPECT_TRUE(Binomial(300, 150) ==
+              Factorial(300) / (Factorial(150) * Factorial(150)));
+  EXPECT_EQ(Binomial(10, 3), BigInt(120));
+  EXPECT_EQ(Binomial(10, 0), BigInt(1));
+  EXPECT_EQ(Binomial(3, 10).ToString(), "0");
+}
+TEST(Factorial, ProductTree) {
+  std::mt19937_64 gen(28);
+  std::vector<BigInt> nums;
+  BigInt expected(1);
+  for (int i = 0; i < 50; ++i) {
+    nums.push_back(RandomBigInt(gen, 1 + gen() % 40, gen() % 2 == 0));
+    expected *= nums.back();
+  }
+  EXPECT_TRUE(ProductOf(nums) == expected);
+  EXPECT_EQ(ProductOf({}), BigInt(1));
+}
+
+TEST(BigRational, ExactArithmeticAndDigits) {
+  BigRational third(BigInt(1), BigInt(3));
+  BigRational sixth(BigInt(-1), BigInt(-6));
+  EXPECT_EQ((third + sixth).ToString(), "1/2");
+  EXPECT_EQ((third - sixth * BigRational(4)).ToString(), "-1/3");
+  EXPECT_TRUE(third / third == BigRational(1));
+  EXPECT_TRUE(BigRational("2/6") == third);
+  DecimalExpansion digits(BigRational(BigInt(-22), BigInt(7)));
+  EXPECT_TRUE(digits.IsNegative());
+  EXPECT_TRUE(digits.IntegerPart() == BigInt(3));
+  EXPECT_EQ(digits.Next(40), "1428571428571428571428571428571428571428");
+  EXPECT_FALSE(digits.Terminated());
+}
+
+TEST(BigRational, ConstReadsLeaveTheValueAlone) {
+  BigRational third(BigInt(1), BigInt(3));
+  BigRational sixth(BigInt(1), BigInt(6));
+  // 9/18 stays unreduced until Normalize
+  const BigRational half = third + sixth;
+  std::vector<std::string> seen(4);
+  std::vector<std::thread> readers;
+  for (std::string& text : seen) {
+    readers.emplace_back([&half, &text] {
+      text = half.ToString() + " " + half.Numerator().ToString() + " " +
+             half.Denominator().ToString();
+    });
+  }
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  for (const std::string& text : seen) {
+    EXPECT_EQ(text, "1/2 1 2");
+  }
+  BigRational reduced = half;
+  reduced.Normalize();
+  EXPECT_TRUE(reduced == half);
+  EXPECT_EQ(reduced.Reduced().ToString(), "1/2");
+  EXPECT_EQ(BigDecimal(half, 3).ToString(), "0.500");
+}
+
+TEST(BigDecimal, RoundingModes) {
+  BigDecimal value("-1.25");
+  EXPECT_EQ(value.Rescale(1, Rounding::kHalfEven).ToString(), "-1.2");
+  EXPECT_EQ(value.Rescale(1, Rounding::kHalfUp).ToString(), "-1.3");
+  EXPECT_EQ(value.Rescale(1, Rounding::kFloor).ToString(), "-1.3");
+  EXPECT_EQ(value.Rescale(1, Rounding::kCeiling).ToString(), "-1.2");
+  EXPECT_EQ(value.Rescale(1, Rounding::kTowardZero).ToString(), "-1.2");
+  EXPECT_EQ(BigDecimal(1).Divide(BigDecimal(3), 5).ToString(), "0.33333");
+  EXPECT_EQ((BigDecimal("0.1") + BigDecimal("0.20")).ToString(), "0.30");
+  EXPECT_TRUE(BigDecimal("1.50") == BigDecimal("1.5"));
+  EXPECT_EQ(BigDecimal("12.3400").Trimmed().ToString(), "12.34");
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
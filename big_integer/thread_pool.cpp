@@ -0,0 +1,150 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+static thread_local ThreadPool* current_pool = nullptr;
+// set only on the threads of a pool
+static thread_local ThreadPool* worker_pool = nullptr;
+static thread_local size_t worker_queue = 0;
+
+ThreadPool::ThreadPool(size_t workers) : workers_(workers) {
+  for (size_t i = 0; i <= workers; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < workers; ++i) {
+    threads_.emplace_back([this, i] { WorkerLoop(i); });
+  }
+}
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+size_t ThreadPool::Workers() const { return workers_; }
+ThreadPool* ThreadPool::Current() { return current_pool; }
+std::shared_ptr<ThreadPool> ThreadPool::Shared(size_t threads) {
+  if (threads == 0) {
+    threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+  if (threads < 2) {
+    return nullptr;
+  }
+  static std::mutex mutex;
+  static std::shared_ptr<ThreadPool> pool;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!pool || pool->Workers() != threads - 1) {
+    pool = std::make_shared<ThreadPool>(threads - 1);
+  }
+  return pool;
+}
+ThreadPool::Scope::Scope(ThreadPool* pool) : previous_(current_pool) {
+  current_pool = pool;
+}
+ThreadPool::Scope::~Scope() { current_pool = previous_; }
+// workers own the first queues, every other thread uses the last one
+size_t ThreadPool::OwnQueue() const {
+  return worker_pool == this ? worker_queue : workers_;
+}
+void ThreadPool::Submit(std::function<void()> task) {
+  Queue& queue = *queues_[OwnQueue()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    queued_.fetch_add(1);
+  }
+  wake_.notify_one();
+}
+bool ThreadPool::Pop(size_t queue, std::function<void()>& task) {
+  Queue& own = *queues_[queue];
+  std::lock_guard<std::mutex> lock(own.mutex);
+  if (own.tasks.empty()) {
+    return false;
+  }
+  task = std::move(own.tasks.back());
+  own.tasks.pop_back();
+  queued_.fetch_sub(1);
+  return true;
+}
+bool ThreadPool::Steal(size_t thief, std::function<void()>& task) {
+  for (size_t step = 1; step < queues_.size(); ++step) {
+    Queue& victim = *queues_[(thief + step) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+bool ThreadPool::RunPendingTask() {
+  size_t queue = OwnQueue();
+  std::function<void()> task;
+  if (!Pop(queue, task) && !Steal(queue, task)) {
+    return false;
+  }
+  task();
+  return true;
+}
+void ThreadPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  worker_pool = this;
+  worker_queue = index;
+  while (true) {
+    if (RunPendingTask()) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+    if (stop_) {
+      return;
+    }
+  }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_(pool) {}
+TaskGroup::~TaskGroup() { Drain(); }
+// a task counts as finished even when it throws, the exception is kept for
+// Wait
+void TaskGroup::Run(std::function<void()> task) {
+  pending_.fetch_add(1);
+  try {
+    pool_.Submit([this, task = std::move(task)] {
+      try {
+        task();
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      pending_.fetch_sub(1);
+    });
+  } catch (...) {
+    pending_.fetch_sub(1);
+    throw;
+  }
+}
+void TaskGroup::Drain() {
+  while (pending_.load() > 0) {
+    if (!pool_.RunPendingTask()) {
+      std::this_thread::yield();
+    }
+  }
+}
+void TaskGroup::Wait() {
+  Drain();
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+// fixed set of workers with one task deque each: a worker runs its own
+// newest task first and steals the oldest ones of the others when idle,
+// threads outside the pool share one more deque
+class ThreadPool {
+ public:
+  explicit ThreadPool(size_t workers);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+  size_t Workers() const;
+  void Submit(std::function<void()> task);
+  // runs one queued task on the calling thread, returns false if none is
+  // queued anywhere
+  bool RunPendingTask();
+  // the pool of the calling worker or the one entered with Scope
+  static ThreadPool* Current();
+  // process-wide pool with threads - 1 workers next to the calling thread,
+  // replaced when threads changes while its users keep the old one, zero
+  // means one thread per hardware thread and nullptr is returned below two
+  static std::shared_ptr<ThreadPool> Shared(size_t threads);
+  class Scope {
+   public:
+    explicit Scope(ThreadPool* pool);
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope();
+
+   private:
+    ThreadPool* previous_;
+  };
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+  size_t OwnQueue() const;
+  bool Pop(size_t queue, std::function<void()>& task);
+  bool Steal(size_t thief, std::function<void()>& task);
+  void WorkerLoop(size_t index);
+
+  size_t workers_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<size_t> queued_{0};
+  bool stop_ = false;
+};
+
+// fork-join over a pool, Wait runs queued tasks instead of blocking, so
+// groups may be nested inside tasks
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool& pool);
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+  // waits for the tasks without rethrowing
+  ~TaskGroup();
+  void Run(std::function<void()> task);
+  // returns once every task has finished and rethrows the first exception
+  // one of them threw
+  void Wait();
+
+ private:
+  void Drain();
+
+  ThreadPool& pool_;
+  std::atomic<size_t> pending_{0};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+// body(first, last) over the whole of [0, count), split into chunks of at
+// least grain items when the caller runs inside a pool
+template <typename Body>
+void ParallelFor(size_t count, size_t grain, const Body& body) {
+  ThreadPool* pool = ThreadPool::Current();
+  if (pool == nullptr || count < 2 * grain) {
+    body(0, count);
+    return;
+  }
+  size_t chunks = std::min(count / grain, 4 * (pool->Workers() + 1));
+  TaskGroup group(*pool);
+  for (size_t c = 1; c < chunks; ++c) {
+    group.Run([&, c] { body(count * c / chunks, count * (c + 1) / chunks); });
+  }
+  body(0, count / chunks);
+  group.Wait();
+}
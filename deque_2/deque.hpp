@@ -1,8 +1,32 @@
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <ranges>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
-template <typename T, typename Allocator = std::allocator<T>>
+// byte budget of one block and the fewest elements a block holds when T is
+// too large for the budget
+inline constexpr size_t kDequeBlockBytes = 4096;
+inline constexpr size_t kDequeMinBlockSize = 16;
+// elements per block, a power of two so that iterator arithmetic compiles
+// to shifts and masks
+template <typename T>
+constexpr size_t DequeBlockSize() {
+  size_t fit = kDequeBlockBytes / sizeof(T);
+  return fit < kDequeMinBlockSize ? kDequeMinBlockSize : std::bit_floor(fit);
+}
+// BlockSize overrides the number of elements per block
+template <typename T, typename Allocator = std::allocator<T>,
+          size_t BlockSize = DequeBlockSize<T>()>
 class Deque {
+  static_assert(BlockSize > 0, "a block holds at least one element");
+
  public:
   /* iterator */
   template <bool IsConst>
@@ -15,11 +39,17 @@ class Deque {
   /* allocator */
   using allocator_type = Allocator;
   using alloc_traits = std::allocator_traits<Allocator>;
+  // move assignment only moves element by element, which allocates, when
+  // the allocators may differ and stay put
+  static constexpr bool kNothrowMoveAssign =
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value;
   Allocator get_allocator() { return alloc_; }
   /* constructor */
   Deque();
   explicit Deque(const Allocator& allocator);
   Deque(const Deque& other);
+  Deque(const Deque& other, const Allocator& alloc);
   Deque(Deque&& other);
   Deque(size_t count, const Allocator& alloc = Allocator());
   Deque(size_t count, const T& k_value, const Allocator& alloc = Allocator());
@@ -27,12 +57,13 @@ class Deque {
   /* destructor */
   ~Deque();
   void clear();
+  // allocates every block of the map now instead of on first touch
   void reserve();
   void resize_back();
   void resize_front();
   /* operators =, [] */
   Deque& operator=(const Deque& other);
-  Deque& operator=(Deque&& other) noexcept;
+  Deque& operator=(Deque&& other) noexcept(kNothrowMoveAssign);
   T& operator[](size_t index);
   const T& operator[](size_t index) const;
   T& at(size_t index);
@@ -55,8 +86,19 @@ class Deque {
   /* insert, erase */
   void insert(iterator deque_it, const T& val);
   void erase(iterator deque_it);
+  // ranges shift only the shorter side, a block at a time and with memmove
+  // when T is trivially copyable; both return an iterator to the first
+  // element after the change
+  template <std::forward_iterator It>
+  iterator insert(iterator deque_it, It first, It last);
+  iterator erase(iterator first, iterator last);
+  /* append, prepend */
+  template <std::ranges::input_range R>
+  void append_range(R&& range);
+  template <std::ranges::input_range R>
+  void prepend_range(R&& range);
   /* swap */
-  void swap(const Deque& other);
+  void swap(Deque& other);
   void copy_from_other(const Deque& other);
   /* iterator */
   iterator begin();
@@ -67,20 +109,121 @@ class Deque {
   reverse_iterator rbegin();
   const_reverse_iterator crend() const;
   const_reverse_iterator crbegin() const;
+  /* block pool */
+  // while enabled, blocks that do not fit the spare stash of a deque go to
+  // a process-wide lock-free pool shared by every deque of this type, and
+  // deques take blocks from it before asking the allocator; disabling it
+  // returns the pooled blocks to the allocator
+  static void enable_block_pool(bool enable);
   const size_t kCountBlock = 64;
 
  private:
+  /* blocks */
+  class block_pool;
+  static block_pool& shared_pool();
+  // a block from the stash, the pool or the allocator, in that order
+  T* take_block();
+  void give_block(T* block);
+  // empties the stash into the pool or the allocator
+  void flush_spare_blocks();
+  // map of count_block null blocks with begin_ and end_ in the middle
+  void init_map(size_t count_block);
+  // also leaves front_blocks and back_blocks free blocks at the ends
+  void recenter_map(size_t front_blocks = 0, size_t back_blocks = 0);
+  // allocated slots for front more elements before begin_ and back more
+  // after end_
+  void make_room(size_t front, size_t back);
+  void allocate_block(size_t block);
+  void release_block(size_t block);
+  // gives the block back once no element lives in it
+  void release_if_unused(size_t block);
+  void release_unused(iterator first, size_t count);
+  /* bulk moves */
+  // count elements from the source into raw slots, destroyed again if one
+  // of them throws, or onto live ones
+  template <typename It>
+  void copy_into(It& source, iterator dest, size_t count, bool raw);
+  // into raw slots that do not overlap the source
+  void move_into_raw(iterator source, iterator dest, size_t count);
+  // between live slots that may overlap
+  void move_within(iterator source, iterator dest, size_t count);
+  void destroy_range(iterator first, size_t count);
+  template <typename It>
+  void insert_counted(size_t index, It first, size_t count);
+  // moves the index elements before the insertion point to the front
+  template <typename It>
+  void insert_by_front(size_t index, It first, size_t count);
+  // moves the elements from the insertion point on to the back
+  template <typename It>
+  void insert_by_back(size_t index, It first, size_t count);
+  // elements are bytes to memcpy and memmove when T is trivially copyable
+  // and the allocator keeps the default construct and destroy
+  static constexpr bool kConstructHook =
+      requires(Allocator alloc, T* ptr, const T& value) {
+    alloc.construct(ptr, value);
+  };
+  static constexpr bool kDestroyHook = requires(Allocator alloc, T* ptr) {
+    alloc.destroy(ptr);
+  };
+  static constexpr bool kBitwise =
+      std::is_trivially_copyable_v<T> && !kConstructHook && !kDestroyHook;
+
   size_t count_block_ = kCountBlock;
-  static const size_t kSizeBlock = 100000;
+  static constexpr size_t kSizeBlock = BlockSize;
+  // blocks are allocated on first touch and released when they drain, so
+  // the map holds null pointers for every block without elements
   std::vector<T*> buff_{count_block_};
   common_iterator<false> begin_;
   common_iterator<false> end_;
   Allocator alloc_;
+  // drained blocks kept for the next ones to fill, so a deque swinging
+  // across a block edge or used as a queue stops calling the allocator
+  static constexpr size_t kSpareBlocks = 2;
+  std::array<T*, kSpareBlocks> spare_blocks_{};
+  size_t spare_count_ = 0;
+  static constexpr size_t kPoolBlocks = 64;
+  static inline std::atomic<bool> pool_enabled_{false};
+};
+/* -----------class block_pool--------------*/
+// fixed slots that blocks are swapped in and out of with one atomic
+// operation each, so no block is ever handed out twice and there is no
+// ABA hazard as with a linked free list
+template <typename T, typename Allocator, size_t BlockSize>
+class Deque<T, Allocator, BlockSize>::block_pool {
+ public:
+  // nullptr when the pool is empty
+  T* take() {
+    for (std::atomic<T*>& slot : slots_) {
+      if (slot.load(std::memory_order_relaxed) != nullptr) {
+        T* block = slot.exchange(nullptr, std::memory_order_acquire);
+        if (block != nullptr) {
+          return block;
+        }
+      }
+    }
+    return nullptr;
+  }
+  // false when every slot is taken
+  bool give(T* block) {
+    for (std::atomic<T*>& slot : slots_) {
+      T* expected = nullptr;
+      if (slot.load(std::memory_order_relaxed) == nullptr &&
+          slot.compare_exchange_strong(expected, block,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  std::array<std::atomic<T*>, kPoolBlocks> slots_{};
 };
 /* -----------class iterator--------------*/
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t BlockSize>
 template <bool IsConst>
-class Deque<T, Allocator>::common_iterator {
+class Deque<T, Allocator, BlockSize>::common_iterator {
  public:
   using value_type = typename std::conditional<IsConst, const T, T>::type;
   using pointer = typename std::conditional<IsConst, const T*, T*>::type;
@@ -89,10 +232,12 @@ class Deque<T, Allocator>::common_iterator {
   using difference_type = typename std::ptrdiff_t;
   size_t block = 0;
   size_t position = 0;
-  Deque<T, Allocator>* container;
+  Deque<T, Allocator, BlockSize>* container = nullptr;
+  common_iterator() = default;
   common_iterator(size_t block, size_t position)
       : block(block), position(position) {}
-  common_iterator(Deque<T, Allocator>* container, size_t block, size_t position)
+  common_iterator(Deque<T, Allocator, BlockSize>* container, size_t block,
+                  size_t position)
       : container(container), block(block), position(position) {}
   common_iterator& operator++() {
     if (position == kSizeBlock - 1) {
@@ -133,17 +278,15 @@ class Deque<T, Allocator>::common_iterator {
     return tmp;
   }
   common_iterator& operator+=(const size_t kValue) {
-    block = (block * kSizeBlock + kValue + position);
-    block /= kSizeBlock;
-    position = (kValue + position);
-    position %= kSizeBlock;
+    size_t index = block * kSizeBlock + position + kValue;
+    block = index / kSizeBlock;
+    position = index % kSizeBlock;
     return *this;
   }
   common_iterator& operator-=(const size_t kValue) {
-    block = (block * kSizeBlock - kValue + position);
-    block /= kSizeBlock;
-    position = (position - kValue);
-    position %= kSizeBlock;
+    size_t index = block * kSizeBlock + position - kValue;
+    block = index / kSizeBlock;
+    position = index % kSizeBlock;
     return *this;
   }
   common_iterator operator+(const size_t kValue) const {
@@ -175,7 +318,9 @@ class Deque<T, Allocator>::common_iterator {
   }
   pointer operator->() { return (container->buff_)[block] + position; }
   pointer operator->() const { return (container->buff_)[block] + position; }
-  reference operator*() { return *((container->buff_)[block] + position); }
+  reference operator*() const {
+    return *((container->buff_)[block] + position);
+  }
 
   difference_type operator-(const common_iterator& other) const {
     if (block != other.block) {
@@ -189,82 +334,164 @@ class Deque<T, Allocator>::common_iterator {
   }
 };
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::reserve() {
-  for (size_t i = 0; i < count_block_; ++i) {
-    buff_[i] = alloc_traits::allocate(alloc_, kSizeBlock * sizeof(T));
+/* blocks */
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::init_map(size_t count_block) {
+  count_block_ = count_block;
+  buff_.assign(count_block_, nullptr);
+  begin_ = iterator(this, (count_block_ - 1) / 2, 0);
+  end_ = begin_;
+}
+// constant initialized and never destroyed, so deques with static storage
+// duration can still use it at exit; the blocks left in it stay reachable
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::block_pool&
+Deque<T, Allocator, BlockSize>::shared_pool() {
+  static block_pool pool;
+  return pool;
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::enable_block_pool(bool enable) {
+  static_assert(alloc_traits::is_always_equal::value,
+                "pooled blocks must be freeable by any allocator instance");
+  pool_enabled_.store(enable, std::memory_order_relaxed);
+  if (!enable) {
+    Allocator alloc;
+    for (T* block = shared_pool().take(); block != nullptr;
+         block = shared_pool().take()) {
+      alloc_traits::deallocate(alloc, block, kSizeBlock);
+    }
   }
 }
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque() : Deque(Allocator()) {}
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(const Allocator& allocator)
-    : begin_(this, (count_block_ - 1) / 2, 0),
-      end_(this, (count_block_ - 1) / 2, 0),
-      alloc_(allocator) {
-  try {
-    reserve();
-  } catch (...) {
-    clear();
-    throw;
+template <typename T, typename Allocator, size_t BlockSize>
+T* Deque<T, Allocator, BlockSize>::take_block() {
+  if (spare_count_ != 0) {
+    return spare_blocks_[--spare_count_];
   }
+  if constexpr (alloc_traits::is_always_equal::value) {
+    if (pool_enabled_.load(std::memory_order_relaxed)) {
+      T* block = shared_pool().take();
+      if (block != nullptr) {
+        return block;
+      }
+    }
+  }
+  return alloc_traits::allocate(alloc_, kSizeBlock);
 }
-
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(const Deque& other)
-    : count_block_((other.size() / kSizeBlock + 1) * 2),
-      buff_(count_block_),
-      begin_(this, (count_block_ - 1) / 2, 0),
-      end_(this, (count_block_ - 1) / 2, 0),
-      alloc_(
-          alloc_traits::select_on_container_copy_construction(other.alloc_)) {
-  try {
-    reserve();
-    for (size_t i = 0; i < other.size(); ++i) {
-      alloc_traits::construct(alloc_, buff_[end_.block] + end_.position,
-                              other.operator[](i));
-      ++end_;
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::give_block(T* block) {
+  if (spare_count_ != kSpareBlocks) {
+    spare_blocks_[spare_count_++] = block;
+    return;
+  }
+  if constexpr (alloc_traits::is_always_equal::value) {
+    if (pool_enabled_.load(std::memory_order_relaxed) &&
+        shared_pool().give(block)) {
+      return;
     }
-  } catch (...) {
-    clear();
-    throw;
   }
+  alloc_traits::deallocate(alloc_, block, kSizeBlock);
 }
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(Deque&& other)
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::flush_spare_blocks() {
+  while (spare_count_ != 0) {
+    T* block = spare_blocks_[--spare_count_];
+    bool pooled = false;
+    if constexpr (alloc_traits::is_always_equal::value) {
+      pooled = pool_enabled_.load(std::memory_order_relaxed) &&
+               shared_pool().give(block);
+    }
+    if (!pooled) {
+      alloc_traits::deallocate(alloc_, block, kSizeBlock);
+    }
+  }
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::allocate_block(size_t block) {
+  if (buff_[block] == nullptr) {
+    buff_[block] = take_block();
+  }
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::release_block(size_t block) {
+  if (buff_[block] != nullptr) {
+    give_block(buff_[block]);
+    buff_[block] = nullptr;
+  }
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::release_if_unused(size_t block) {
+  bool used =
+      !empty() && begin_.block <= block &&
+      (block < end_.block || (block == end_.block && end_.position != 0));
+  if (!used) {
+    release_block(block);
+  }
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::release_unused(iterator first,
+                                                    size_t count) {
+  if (count != 0) {
+    for (size_t i = first.block; i <= (first + (count - 1)).block; ++i) {
+      release_if_unused(i);
+    }
+  }
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::reserve() {
+  for (size_t i = 0; i < count_block_; ++i) {
+    allocate_block(i);
+  }
+}
+
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque() : Deque(Allocator()) {}
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque(const Allocator& allocator)
+    : begin_(this, (count_block_ - 1) / 2, 0),
+      end_(this, (count_block_ - 1) / 2, 0),
+      alloc_(allocator) {}
+
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque(const Deque& other)
+    : Deque(other,
+            alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+}
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque(const Deque& other,
+                                      const Allocator& alloc)
     : count_block_((other.size() / kSizeBlock + 1) * 2),
       buff_(count_block_),
       begin_(this, (count_block_ - 1) / 2, 0),
       end_(this, (count_block_ - 1) / 2, 0),
-      alloc_(
-          alloc_traits::select_on_container_copy_construction(other.alloc_)) {
+      alloc_(alloc) {
   try {
-    reserve();
-    for (size_t i = 0; i < other.size(); ++i) {
-      alloc_traits::construct(alloc_, buff_[end_.block] + end_.position,
-                              std::move(other.operator[](i)));
-      ++end_;
-    }
-    while (other.begin_ != other.end_) {
-      other.pop_back();
-    }
+    copy_from_other(other);
   } catch (...) {
     clear();
     throw;
   }
 }
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(size_t count, const Allocator& alloc)
+// takes over the blocks of other, which is left empty
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque(Deque&& other)
+    : count_block_(other.count_block_),
+      buff_(std::move(other.buff_)),
+      begin_(this, other.begin_.block, other.begin_.position),
+      end_(this, other.end_.block, other.end_.position),
+      alloc_(other.alloc_) {
+  other.init_map(kCountBlock);
+}
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque(size_t count, const Allocator& alloc)
     : count_block_((count / kSizeBlock + 1) * 2),
       buff_(count_block_),
       begin_(this, (count_block_ - 1) / 2, 0),
       end_(this, (count_block_ - 1) / 2, 0),
       alloc_(alloc) {
   try {
-    reserve();
     for (size_t i = 0; i < count; ++i) {
-      alloc_traits::construct(alloc_, buff_[end_.block] + end_.position);
-      ++end_;
+      emplace_back();
     }
   } catch (...) {
     clear();
@@ -272,39 +499,34 @@ Deque<T, Allocator>::Deque(size_t count, const Allocator& alloc)
   }
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(size_t count, const T& k_value,
-                           const Allocator& alloc)
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque(size_t count, const T& k_value,
+                                      const Allocator& alloc)
     : count_block_((count / kSizeBlock + 1) * 2),
+      buff_(count_block_),
       begin_(this, (count_block_ - 1) / 2, 0),
       end_(this, (count_block_ - 1) / 2, 0),
-      buff_(count_block_),
       alloc_(alloc) {
   try {
-    reserve();
     for (size_t i = 0; i < count; ++i) {
-      alloc_traits::construct(alloc_, buff_[end_.block] + end_.position,
-                              k_value);
-      ++end_;
+      emplace_back(k_value);
     }
   } catch (...) {
     clear();
     throw;
   }
 }
-template <typename T, typename Allocator>
-Deque<T, Allocator>::Deque(std::initializer_list<T> init,
-                           const Allocator& alloc)
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::Deque(std::initializer_list<T> init,
+                                      const Allocator& alloc)
     : count_block_((init.size() / kSizeBlock + 1) * 2),
+      buff_(count_block_),
       begin_(this, (count_block_ - 1) / 2, 0),
       end_(this, (count_block_ - 1) / 2, 0),
-      buff_(count_block_),
       alloc_(alloc) {
   try {
-    reserve();
     for (auto& value : init) {
-      alloc_traits::construct(alloc_, buff_[end_.block] + end_.position, value);
-      ++end_;
+      emplace_back(value);
     }
   } catch (...) {
     clear();
@@ -313,112 +535,88 @@ Deque<T, Allocator>::Deque(std::initializer_list<T> init,
 }
 
 /*------------------clear--------------*/
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::clear() {
-  size_t size_deque = size();
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::clear() {
+  while (!empty()) {
+    pop_back();
+  }
   for (size_t i = 0; i < count_block_; ++i) {
-    for (size_t j = 0; j < kSizeBlock && i * kSizeBlock + j < size_deque; ++j) {
-      pop_back();
-    }
-    alloc_traits::deallocate(alloc_, buff_[i], kSizeBlock * sizeof(T));
+    release_block(i);
   }
+  flush_spare_blocks();
+  begin_ = iterator(this, (count_block_ - 1) / 2, 0);
+  end_ = begin_;
 }
 /* destructor */
-template <typename T, typename Allocator>
-Deque<T, Allocator>::~Deque() {
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>::~Deque() {
   clear();
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::swap(const Deque<T, Allocator>& other) {
-  count_block_ = other.count_block_;
-  begin_ = other.begin_;
-  end_ = other.begin_;
-  alloc_ = std::move(other.alloc_);
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::swap(
+    Deque<T, Allocator, BlockSize>& other) {
+  std::swap(count_block_, other.count_block_);
+  std::swap(buff_, other.buff_);
+  std::swap(begin_, other.begin_);
+  std::swap(end_, other.end_);
+  std::swap(alloc_, other.alloc_);
+  std::swap(spare_blocks_, other.spare_blocks_);
+  std::swap(spare_count_, other.spare_count_);
+  begin_.container = this;
+  end_.container = this;
+  other.begin_.container = &other;
+  other.end_.container = &other;
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::copy_from_other(const Deque<T, Allocator>& other) {
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::copy_from_other(
+    const Deque<T, Allocator, BlockSize>& other) {
   for (size_t i = 0; i < other.size(); ++i) {
-    alloc_traits::construct(alloc_, buff_[end_.block] + end_.position,
-                            other[i]);
-    ++end_;
+    emplace_back(other[i]);
   }
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>& Deque<T, Allocator>::operator=(
-    const Deque<T, Allocator>& other) {
+// the copy is built aside with the allocator the assignment ends up with,
+// so a throwing copy leaves *this untouched
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>& Deque<T, Allocator, BlockSize>::operator=(
+    const Deque<T, Allocator, BlockSize>& other) {
   if (this != &other) {
-    if (size() != other.size()) {
-      try {
-        if (size() > other.size()) {
-          clear();
-          buff_.clear();
-          reserve();
-        } else {
-          for (size_t i = 0; i < other.count_block_ - count_block_; ++i) {
-            buff_.push_back(alloc_.allocate(kSizeBlock * sizeof(T)));
-          }
-        }
-        swap(other);
-        copy_from_other(other);
-      } catch (...) {
-        for (; begin_ != end_;) {
-          pop_back();
-        }
-        throw;
-      }
-    } else {
-      if constexpr (alloc_traits::propagate_on_container_copy_assignment::
-                        value) {
-        alloc_ = std::move(other.alloc_);
-      }
-      end_ = begin_;
-      copy_from_other(other);
-    }
+    Deque copy(other,
+               alloc_traits::propagate_on_container_copy_assignment::value
+                   ? other.alloc_
+                   : alloc_);
+    swap(copy);
   }
   return *this;
 }
 
-template <typename T, typename Allocator>
-Deque<T, Allocator>& Deque<T, Allocator>::operator=(
-    Deque<T, Allocator>&& other) noexcept {
+// blocks change hands without allocating when the allocators allow it and
+// other is left with our old blocks, emptied; otherwise the elements are
+// moved one by one into blocks of our allocator
+template <typename T, typename Allocator, size_t BlockSize>
+Deque<T, Allocator, BlockSize>& Deque<T, Allocator, BlockSize>::operator=(
+    Deque<T, Allocator, BlockSize>&& other) noexcept(kNothrowMoveAssign) {
   if (this != &other) {
-    if (size() != other.size()) {
-      try {
-        if (size() > other.size()) {
-          clear();
-          buff_.clear();
-          reserve();
-        } else {
-          for (size_t i = 0; i < other.count_block_ - count_block_; ++i) {
-            buff_.push_back(alloc_.allocate(kSizeBlock * sizeof(T)));
-          }
-        }
-        swap(other);
-        copy_from_other(std::move(other));
-      } catch (...) {
-        for (; begin_ != end_;) {
-          alloc_traits::destroy(alloc_, buff_[end_.block] + end_.position);
-          --end_;
-        }
-        throw;
-      }
+    if (alloc_traits::propagate_on_container_move_assignment::value ||
+        alloc_ == other.alloc_) {
+      swap(other);
+      other.clear();
     } else {
-      if constexpr (alloc_traits::propagate_on_container_copy_assignment::
-                        value) {
-        alloc_ = std::move(other.alloc_);
+      Deque moved(alloc_);
+      for (size_t i = 0; i < other.size(); ++i) {
+        moved.emplace_back(std::move(other[i]));
       }
-      end_ = begin_;
-      copy_from_other(other);
+      other.clear();
+      swap(moved);
     }
   }
   return *this;
 }
 
-template <typename T, typename Allocator>
-size_t Deque<T, Allocator>::size() const {
+template <typename T, typename Allocator, size_t BlockSize>
+size_t Deque<T, Allocator, BlockSize>::size() const {
   if (begin_.block != end_.block) {
     return (end_.block - begin_.block - 1) * kSizeBlock + kSizeBlock +
            end_.position - begin_.position;
@@ -426,8 +624,8 @@ size_t Deque<T, Allocator>::size() const {
   return end_.position - begin_.position;
 }
 
-template <typename T, typename Allocator>
-bool Deque<T, Allocator>::empty() {
+template <typename T, typename Allocator, size_t BlockSize>
+bool Deque<T, Allocator, BlockSize>::empty() {
   if (begin_.block == end_.block) {
     if (end_.position == begin_.position) {
       return true;
@@ -436,186 +634,451 @@ bool Deque<T, Allocator>::empty() {
   return false;
 }
 
-template <typename T, typename Allocator>
-T& Deque<T, Allocator>::operator[](size_t index) {
+template <typename T, typename Allocator, size_t BlockSize>
+T& Deque<T, Allocator, BlockSize>::operator[](size_t index) {
   iterator deque_it = begin_;
   deque_it += index;
   return *(buff_[deque_it.block] + deque_it.position);
 }
 
-template <typename T, typename Allocator>
-const T& Deque<T, Allocator>::operator[](size_t index) const {
+template <typename T, typename Allocator, size_t BlockSize>
+const T& Deque<T, Allocator, BlockSize>::operator[](size_t index) const {
   iterator deque_it = begin_;
   deque_it += index;
   return *(buff_[deque_it.block] + deque_it.position);
 }
 
-template <typename T, typename Allocator>
-T& Deque<T, Allocator>::at(size_t index) {
+template <typename T, typename Allocator, size_t BlockSize>
+T& Deque<T, Allocator, BlockSize>::at(size_t index) {
   if (index >= size()) {
     throw std::out_of_range("Out of range");
   }
-  return Deque<T>::operator[](index);
+  return operator[](index);
 }
 
-template <typename T, typename Allocator>
-const T& Deque<T, Allocator>::at(size_t index) const {
+template <typename T, typename Allocator, size_t BlockSize>
+const T& Deque<T, Allocator, BlockSize>::at(size_t index) const {
   if (index >= size()) {
     throw std::out_of_range("Out of range");
   }
-  return Deque<T, Allocator>::operator[](index);
+  return Deque<T, Allocator, BlockSize>::operator[](index);
 }
 
 /* resize */
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::resize_back() {
+// the live blocks move to the middle of the map, which doubles only when
+// they fill half of it, so either end runs out of room after at least a
+// quarter of the map more blocks and both ends grow in amortized O(1);
+// the map is rotated as a whole, so allocated blocks outside the live
+// range come round to the other end and are reused there
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::recenter_map(size_t front_blocks,
+                                                  size_t back_blocks) {
+  size_t live = end_.block - begin_.block + 1;
+  size_t need = live + front_blocks + back_blocks;
+  if (2 * need >= count_block_) {
+    count_block_ = std::max(2 * count_block_, 2 * need + 2);
+    buff_.resize(count_block_, nullptr);
+  }
+  size_t first = (count_block_ - need) / 2 + front_blocks;
+  size_t shift = (begin_.block + count_block_ - first) % count_block_;
+  std::rotate(buff_.begin(), buff_.begin() + shift, buff_.end());
+  end_.block = first + live - 1;
+  begin_.block = first;
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::resize_back() {
   if (end_.block == count_block_ && end_.position == 0) {
-    size_t size_tmp = end_.block - begin_.block + 1;
-    // copy all elem
-    size_t index = 0;
-    while (index < size_tmp) {
-      buff_.push_back(alloc_traits::allocate(alloc_, kSizeBlock * sizeof(T)));
-      ++index;
-    }
-    count_block_ += size_tmp;
+    recenter_map();
   }
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::resize_front() {
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::resize_front() {
   if (begin_.block == 0 && begin_.position == 0) {
-    size_t size_tmp = end_.block - begin_.block + 1;
-    // copy all elem
-    size_t index = 0;
-    while (index < size_tmp) {
-      buff_.insert(buff_.begin(), 1,
-                   alloc_traits::allocate(alloc_, kSizeBlock * sizeof(T)));
-      ++index;
+    recenter_map();
+  }
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::make_room(size_t front, size_t back) {
+  size_t front_room = begin_.block * kSizeBlock + begin_.position;
+  size_t back_room = (count_block_ - end_.block) * kSizeBlock - end_.position;
+  if (front_room < front || back_room < back) {
+    recenter_map((front + kSizeBlock - 1) / kSizeBlock,
+                 (back + kSizeBlock - 1) / kSizeBlock);
+  }
+  if (front != 0) {
+    for (size_t i = (begin_ - front).block; i <= (begin_ - 1).block; ++i) {
+      allocate_block(i);
+    }
+  }
+  if (back != 0) {
+    for (size_t i = end_.block; i <= (end_ + (back - 1)).block; ++i) {
+      allocate_block(i);
     }
-    end_.block += size_tmp;
-    begin_.block += size_tmp;
-    count_block_ += size_tmp;
   }
 }
 /* push_back(T&&) */
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_back(T&& value) {
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::push_back(T&& value) {
   emplace_back(std::forward<T>(value));
 }
 /* push_back(T&) */
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_back(const T& k_value) {
-  resize_back();
-  alloc_traits::construct(alloc_, buff_[end_.block] + end_.position, k_value);
-  ++end_;
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::push_back(const T& k_value) {
+  emplace_back(k_value);
 }
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t BlockSize>
 template <typename... Args>
-void Deque<T, Allocator>::emplace_back(Args&&... args) {
+void Deque<T, Allocator, BlockSize>::emplace_back(Args&&... args) {
   resize_back();
-  alloc_traits::construct(alloc_, buff_[end_.block] + end_.position,
-                          std::forward<Args>(args)...);
+  allocate_block(end_.block);
+  try {
+    alloc_traits::construct(alloc_, buff_[end_.block] + end_.position,
+                            std::forward<Args>(args)...);
+  } catch (...) {
+    release_if_unused(end_.block);
+    throw;
+  }
   ++end_;
 }
-template <typename T, typename Allocator>
+template <typename T, typename Allocator, size_t BlockSize>
 template <typename... Args>
-void Deque<T, Allocator>::emplace_front(Args&&... args) {
+void Deque<T, Allocator, BlockSize>::emplace_front(Args&&... args) {
   resize_front();
-  --begin_;
-  alloc_traits::construct(alloc_, buff_[begin_.block] + begin_.position,
-                          std::forward<Args>(args)...);
+  iterator front = begin_;
+  --front;
+  allocate_block(front.block);
+  try {
+    alloc_traits::construct(alloc_, buff_[front.block] + front.position,
+                            std::forward<Args>(args)...);
+  } catch (...) {
+    release_if_unused(front.block);
+    throw;
+  }
+  begin_ = front;
 }
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::pop_back() {
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::pop_back() {
   --end_;
   alloc_traits::destroy(alloc_, buff_[end_.block] + end_.position);
+  release_if_unused(end_.block);
 }
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_front(const T& k_value) {
-  resize_front();
-  --begin_;
-  alloc_traits::construct(alloc_, buff_[begin_.block] + begin_.position,
-                          k_value);
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::push_front(const T& k_value) {
+  emplace_front(k_value);
 }
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::push_front(T&& value) {
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::push_front(T&& value) {
   emplace_front(std::forward<T>(value));
 }
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::pop_front() {
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::pop_front() {
+  size_t block = begin_.block;
   alloc_traits::destroy(alloc_, buff_[begin_.block] + begin_.position);
   ++begin_;
+  release_if_unused(block);
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::insert(Deque<T, Allocator>::iterator deque_it,
-                                 const T& val) {
-  if (begin_ == deque_it) {
-    push_front(val);
-    return;
+/* bulk moves */
+template <typename T, typename Allocator, size_t BlockSize>
+template <typename It>
+void Deque<T, Allocator, BlockSize>::copy_into(It& source, iterator dest,
+                                               size_t count, bool raw) {
+  iterator start = dest;
+  size_t done = 0;
+  try {
+    while (done < count) {
+      size_t chunk = std::min(count - done, kSizeBlock - dest.position);
+      T* slot = buff_[dest.block] + dest.position;
+      if constexpr (kBitwise && std::contiguous_iterator<It> &&
+                    std::is_same_v<std::iter_value_t<It>, T>) {
+        std::memcpy(slot, std::to_address(source), chunk * sizeof(T));
+        source += chunk;
+        done += chunk;
+      } else {
+        for (size_t i = 0; i < chunk; ++i, ++source, ++done) {
+          if (raw) {
+            alloc_traits::construct(alloc_, slot + i, *source);
+          } else {
+            slot[i] = *source;
+          }
+        }
+      }
+      dest += chunk;
+    }
+  } catch (...) {
+    if (raw) {
+      destroy_range(start, done);
+    }
+    throw;
+  }
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::move_into_raw(iterator source,
+                                                   iterator dest,
+                                                   size_t count) {
+  iterator start = dest;
+  size_t done = 0;
+  try {
+    while (done < count) {
+      size_t chunk = std::min({count - done, kSizeBlock - source.position,
+                               kSizeBlock - dest.position});
+      T* from = buff_[source.block] + source.position;
+      T* to = buff_[dest.block] + dest.position;
+      if constexpr (kBitwise) {
+        std::memcpy(to, from, chunk * sizeof(T));
+        done += chunk;
+      } else {
+        for (size_t i = 0; i < chunk; ++i, ++done) {
+          alloc_traits::construct(alloc_, to + i, std::move(from[i]));
+        }
+      }
+      source += chunk;
+      dest += chunk;
+    }
+  } catch (...) {
+    destroy_range(start, done);
+    throw;
+  }
+}
+// block by block in the direction that never overwrites a slot before it
+// is read
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::move_within(iterator source, iterator dest,
+                                                 size_t count) {
+  if constexpr (kBitwise) {
+    if (dest < source) {
+      for (size_t left = count; left != 0;) {
+        size_t chunk = std::min(
+            {left, kSizeBlock - source.position, kSizeBlock - dest.position});
+        std::memmove(buff_[dest.block] + dest.position,
+                     buff_[source.block] + source.position, chunk * sizeof(T));
+        source += chunk;
+        dest += chunk;
+        left -= chunk;
+      }
+    } else {
+      source += count;
+      dest += count;
+      for (size_t left = count; left != 0;) {
+        size_t chunk =
+            std::min({left, source.position == 0 ? kSizeBlock : source.position,
+                      dest.position == 0 ? kSizeBlock : dest.position});
+        source -= chunk;
+        dest -= chunk;
+        std::memmove(buff_[dest.block] + dest.position,
+                     buff_[source.block] + source.position, chunk * sizeof(T));
+        left -= chunk;
+      }
+    }
+  } else if (dest < source) {
+    std::move(source, source + count, dest);
+  } else {
+    std::move_backward(source, source + count, dest + count);
   }
-  push_back(*(end_ - 1));
-  iterator sdvig = end_ - 2;
-  while (sdvig > deque_it) {
-    *(sdvig) = *(sdvig - 1);
-    --sdvig;
+}
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::destroy_range(iterator first,
+                                                   size_t count) {
+  if constexpr (!kBitwise) {
+    for (size_t i = 0; i < count; ++i, ++first) {
+      alloc_traits::destroy(alloc_, buff_[first.block] + first.position);
+    }
   }
-  *deque_it = val;
 }
 
-template <typename T, typename Allocator>
-void Deque<T, Allocator>::erase(Deque<T, Allocator>::iterator deque_it) {
-  if (begin_ == deque_it) {
-    pop_front();
+/* insert, erase */
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::insert(
+    Deque<T, Allocator, BlockSize>::iterator deque_it, const T& val) {
+  // a copy first, val may live in the part that shifts
+  T copy(val);
+  insert_counted(deque_it - begin_, std::make_move_iterator(&copy), 1);
+}
+
+template <typename T, typename Allocator, size_t BlockSize>
+void Deque<T, Allocator, BlockSize>::erase(
+    Deque<T, Allocator, BlockSize>::iterator deque_it) {
+  erase(deque_it, deque_it + 1);
+}
+
+template <typename T, typename Allocator, size_t BlockSize>
+template <std::forward_iterator It>
+typename Deque<T, Allocator, BlockSize>::iterator
+Deque<T, Allocator, BlockSize>::insert(iterator deque_it, It first, It last) {
+  size_t index = deque_it - begin_;
+  insert_counted(index, first, std::ranges::distance(first, last));
+  return begin_ + index;
+}
+
+// the shorter side moves count slots outwards into freshly made room; the
+// source elements that land on raw slots are constructed before anything
+// moves, so when the whole range lands on raw slots a throwing copy leaves
+// the deque as it was, otherwise a throw while the source is assigned onto
+// shifted slots leaves a valid deque of unspecified elements
+template <typename T, typename Allocator, size_t BlockSize>
+template <typename It>
+void Deque<T, Allocator, BlockSize>::insert_counted(size_t index, It first,
+                                                    size_t count) {
+  if (count == 0) {
     return;
   }
-  iterator sdvig = deque_it + 1;
-  while (sdvig < end_) {
-    *(sdvig - 1) = *sdvig;
-    ++sdvig;
+  if (index < size() - index) {
+    insert_by_front(index, first, count);
+  } else {
+    insert_by_back(index, first, count);
+  }
+}
+
+// the first moved elements go onto raw slots, the rest shift onto live ones
+// and the source fills the gap, its head on raw slots if index < count
+template <typename T, typename Allocator, size_t BlockSize>
+template <typename It>
+void Deque<T, Allocator, BlockSize>::insert_by_front(size_t index, It first,
+                                                     size_t count) {
+  make_room(count, 0);
+  iterator old_begin = begin_;
+  iterator new_begin = begin_ - count;
+  size_t moved = std::min(index, count);
+  size_t fresh = count - moved;
+  size_t built = 0;
+  try {
+    copy_into(first, new_begin + index, fresh, true);
+    built = fresh;
+    move_into_raw(old_begin, new_begin, moved);
+  } catch (...) {
+    destroy_range(new_begin + index, built);
+    release_unused(new_begin, count);
+    throw;
+  }
+  begin_ = new_begin;
+  move_within(old_begin + moved, old_begin, index - moved);
+  copy_into(first, new_begin + (index + fresh), moved, false);
+}
+
+// the mirror image of insert_by_front, the tail of the source goes onto
+// raw slots if fewer than count elements follow the insertion point
+template <typename T, typename Allocator, size_t BlockSize>
+template <typename It>
+void Deque<T, Allocator, BlockSize>::insert_by_back(size_t index, It first,
+                                                    size_t count) {
+  size_t after = size() - index;
+  make_room(0, count);
+  iterator old_end = end_;
+  iterator deque_it = begin_ + index;
+  size_t moved = std::min(after, count);
+  size_t fresh = count - moved;
+  It tail = fresh == 0 ? first : std::ranges::next(first, moved);
+  size_t built = 0;
+  try {
+    copy_into(tail, old_end, fresh, true);
+    built = fresh;
+    move_into_raw(old_end - moved, old_end + fresh, moved);
+  } catch (...) {
+    destroy_range(old_end, built);
+    release_unused(old_end, count);
+    throw;
+  }
+  end_ = old_end + count;
+  move_within(deque_it, deque_it + count, after - moved);
+  copy_into(first, deque_it, moved, false);
+}
+
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::iterator
+Deque<T, Allocator, BlockSize>::erase(iterator first, iterator last) {
+  size_t index = first - begin_;
+  size_t count = last - first;
+  if (count == 0) {
+    return first;
+  }
+  if (index < size() - index - count) {
+    move_within(begin_, begin_ + count, index);
+    iterator old_begin = begin_;
+    destroy_range(old_begin, count);
+    begin_ += count;
+    release_unused(old_begin, count);
+  } else {
+    move_within(last, first, end_ - last);
+    end_ -= count;
+    destroy_range(end_, count);
+    release_unused(end_, count);
+  }
+  return begin_ + index;
+}
+
+template <typename T, typename Allocator, size_t BlockSize>
+template <std::ranges::input_range R>
+void Deque<T, Allocator, BlockSize>::append_range(R&& range) {
+  if constexpr (std::ranges::forward_range<R>) {
+    insert_counted(size(), std::ranges::begin(range),
+                   std::ranges::distance(range));
+  } else {
+    for (auto&& value : range) {
+      emplace_back(std::forward<decltype(value)>(value));
+    }
+  }
+}
+
+template <typename T, typename Allocator, size_t BlockSize>
+template <std::ranges::input_range R>
+void Deque<T, Allocator, BlockSize>::prepend_range(R&& range) {
+  if constexpr (std::ranges::forward_range<R>) {
+    insert_counted(0, std::ranges::begin(range), std::ranges::distance(range));
+  } else {
+    size_t count = 0;
+    for (auto&& value : range) {
+      emplace_front(std::forward<decltype(value)>(value));
+      ++count;
+    }
+    std::reverse(begin_, begin_ + count);
   }
-  pop_back();
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::iterator Deque<T, Allocator>::begin() {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::iterator
+Deque<T, Allocator, BlockSize>::begin() {
   return begin_;
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::const_iterator Deque<T, Allocator>::cbegin()
-    const {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::const_iterator
+Deque<T, Allocator, BlockSize>::cbegin() const {
   return begin_;
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::iterator Deque<T, Allocator>::end() {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::iterator
+Deque<T, Allocator, BlockSize>::end() {
   return end_;
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::const_iterator Deque<T, Allocator>::cend() const {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::const_iterator
+Deque<T, Allocator, BlockSize>::cend() const {
   return end_;
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::reverse_iterator Deque<T, Allocator>::rend() {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::reverse_iterator
+Deque<T, Allocator, BlockSize>::rend() {
   return std::make_reverse_iterator(begin());
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::reverse_iterator Deque<T, Allocator>::rbegin() {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::reverse_iterator
+Deque<T, Allocator, BlockSize>::rbegin() {
   return std::make_reverse_iterator(end());
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::const_reverse_iterator
-Deque<T, Allocator>::crend() const {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::const_reverse_iterator
+Deque<T, Allocator, BlockSize>::crend() const {
   return std::make_reverse_iterator(cbegin());
 }
 
-template <typename T, typename Allocator>
-typename Deque<T, Allocator>::const_reverse_iterator
-Deque<T, Allocator>::crbegin() const {
+template <typename T, typename Allocator, size_t BlockSize>
+typename Deque<T, Allocator, BlockSize>::const_reverse_iterator
+Deque<T, Allocator, BlockSize>::crbegin() const {
   return std::make_reverse_iterator(cend());
 }
@@ -146,4 +146,33 @@ struct WhimsicalAllocator : public std::allocator<T> {
   }
 
   static size_t counter;
-};
\ No newline at end of file
+};
+// stateful allocator that stays with its container on move assignment, so
+// unequal instances force the element-wise move
+template <typename T>
+struct StickyAllocator : public std::allocator<T> {
+  using propagate_on_container_move_assignment = std::false_type;
+  using is_always_equal = std::false_type;
+
+  template <typename U>
+  struct rebind {
+    using other = StickyAllocator<U>;
+  };
+
+  StickyAllocator(int id = 0) : id(id) {}
+
+  template <typename U>
+  StickyAllocator(const StickyAllocator<U>& another) : id(another.id) {}
+
+  template <typename U>
+  bool operator==(const StickyAllocator<U>& another) const {
+    return id == another.id;
+  }
+
+  template <typename U>
+  bool operator!=(const StickyAllocator<U>& another) const {
+    return id != another.id;
+  }
+
+  int id;
+};